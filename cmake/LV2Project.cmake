@@ -7,6 +7,9 @@ endif()
 
 message("LV2 plugin uses dynamic manifest: ${USE_DYN_MANIFEST}")
 
+message("LV2 plugin uses thread pool: ${ENABLE_THREAD_POOL}")
+find_package(Threads REQUIRED)
+
 if(IS_DIRECTORY "${PROJECT_SOURCE_DIR}/thirdparty/lv2")
   message(STATUS "Using bundled LV2")
   set(LV2_INCLUDE_DIRS "${PROJECT_SOURCE_DIR}/thirdparty/lv2")
@@ -33,11 +36,81 @@ if(NOT USE_DYN_MANIFEST AND NOT CMAKE_CROSSCOMPILING)
   endif()
 endif()
 
+if(NOT CMAKE_CROSSCOMPILING)
+  add_executable(lv2bench tools/lv2bench.cc)
+  target_include_directories(lv2bench
+    PRIVATE "${PROJECT_SOURCE_DIR}/sources"
+    PRIVATE ${LV2_INCLUDE_DIRS}
+    PRIVATE ${Boost_INCLUDE_DIRS})
+  if(CMAKE_SYSTEM_NAME MATCHES "Linux")
+    target_link_libraries(lv2bench dl)
+  endif()
+endif()
+
+if(CMAKE_SYSTEM_NAME MATCHES "Linux")
+  add_library(rtcheck SHARED tools/rtcheck.cc)
+  target_link_libraries(rtcheck dl)
+endif()
+
+add_executable(poolbench
+  tools/poolbench.cc
+  "${PROJECT_SOURCE_DIR}/sources/framework/threadpool.cc"
+  "${PROJECT_SOURCE_DIR}/sources/framework/voices.cc")
+target_include_directories(poolbench PRIVATE "${PROJECT_SOURCE_DIR}/sources")
+target_link_libraries(poolbench Threads::Threads)
+
+set(LV2_KERNEL_ISAS)
+if(CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang" AND
+    CMAKE_SYSTEM_PROCESSOR MATCHES "^(x86_64|AMD64|amd64|i.86|x86)$")
+  include(CheckCXXCompilerFlag)
+  check_cxx_compiler_flag("-msse2" HAVE_CXX_FLAG_SSE2)
+  check_cxx_compiler_flag("-mavx2" HAVE_CXX_FLAG_AVX2)
+  check_cxx_compiler_flag("-mavx512f" HAVE_CXX_FLAG_AVX512F)
+  if(HAVE_CXX_FLAG_SSE2)
+    list(APPEND LV2_KERNEL_ISAS "SSE2")
+    set(LV2_KERNEL_FLAGS_SSE2 "-msse2")
+  endif()
+  if(HAVE_CXX_FLAG_AVX2)
+    list(APPEND LV2_KERNEL_ISAS "AVX2")
+    set(LV2_KERNEL_FLAGS_AVX2 "-mavx2")
+  endif()
+  if(HAVE_CXX_FLAG_AVX512F)
+    list(APPEND LV2_KERNEL_ISAS "AVX512")
+    set(LV2_KERNEL_FLAGS_AVX512 "-mavx512f")
+  endif()
+endif()
+message("LV2 plugin kernel instruction sets: ${LV2_KERNEL_ISAS}")
+
+macro(target_lv2_kernels name)
+  target_sources(${name} PRIVATE
+    "${PROJECT_SOURCE_DIR}/sources/framework/kernels.cc")
+  foreach(_isa ${LV2_KERNEL_ISAS})
+    string(TOLOWER "${_isa}" _isa_lower)
+    set(_source "${PROJECT_SOURCE_DIR}/sources/framework/kernels_${_isa_lower}.cc")
+    target_sources(${name} PRIVATE "${_source}")
+    set_source_files_properties("${_source}" PROPERTIES
+      COMPILE_FLAGS "${LV2_KERNEL_FLAGS_${_isa}}")
+    target_compile_definitions(${name} PRIVATE "KERNELS_HAVE_${_isa}=1")
+  endforeach()
+endmacro()
+
 macro(add_lv2_fx name)
   add_library(${name} MODULE
     ${ARGN}
+    "${PROJECT_SOURCE_DIR}/sources/framework/loadmeter.cc"
     "${PROJECT_SOURCE_DIR}/sources/framework/lv2manifest.cc"
-    "${PROJECT_SOURCE_DIR}/sources/framework/lv2plugin.cc")
+    "${PROJECT_SOURCE_DIR}/sources/framework/lv2plugin.cc"
+    "${PROJECT_SOURCE_DIR}/sources/framework/profiler.cc"
+    "${PROJECT_SOURCE_DIR}/sources/framework/telemetry.cc"
+    "${PROJECT_SOURCE_DIR}/sources/framework/voices.cc"
+    "${PROJECT_SOURCE_DIR}/sources/framework/threadpool.cc"
+    "${PROJECT_SOURCE_DIR}/sources/framework/turtle.cc"
+    "${PROJECT_SOURCE_DIR}/sources/framework/worker.cc")
+  target_lv2_kernels(${name})
+  target_link_libraries(${name} Threads::Threads)
+  if(ENABLE_THREAD_POOL)
+    target_compile_definitions(${name} PRIVATE "ENABLE_THREAD_POOL=1")
+  endif()
   set_target_properties(${name} PROPERTIES
     PREFIX "" SUFFIX ".fx"
     LIBRARY_OUTPUT_NAME "${PROJECT_NAME}"
@@ -67,6 +140,7 @@ macro(add_lv2_fx name)
   if(ENABLE_PROFILER)
     target_include_directories(${name} PRIVATE ${PROFILER_INCLUDE_DIRS})
     target_link_libraries(${name} ${PROFILER_LIBRARIES})
+    target_compile_definitions(${name} PRIVATE "ENABLE_PROFILER=1")
   endif()
   install(DIRECTORY "${PROJECT_BINARY_DIR}/lv2" DESTINATION "lib")
 endmacro()
@@ -74,7 +148,9 @@ endmacro()
 macro(add_lv2_ui name)
   add_library(${name} MODULE
     ${ARGN}
-    "${PROJECT_SOURCE_DIR}/sources/framework/lv2ui.cc")
+    "${PROJECT_SOURCE_DIR}/sources/framework/lv2ui.cc"
+    "${PROJECT_SOURCE_DIR}/sources/framework/telemetry.cc")
+  target_lv2_kernels(${name})
   set_target_properties(${name} PROPERTIES
     PREFIX "" SUFFIX ".ui"
     LIBRARY_OUTPUT_NAME "${PROJECT_NAME}"
@@ -88,10 +164,6 @@ macro(add_lv2_ui name)
   target_include_directories(${name}
     PRIVATE ${LV2_INCLUDE_DIRS}
     PRIVATE ${Boost_INCLUDE_DIRS})
-  if(ENABLE_PROFILER)
-    target_include_directories(${name} PRIVATE ${PROFILER_INCLUDE_DIRS})
-    target_link_libraries(${name} ${PROFILER_LIBRARIES})
-  endif()
 endmacro()
 
 macro(add_lv2_qt5ui name)
@@ -128,7 +200,8 @@ macro(add_lv2_glui name)
   include(TargetPugl)
   find_package(GLEW REQUIRED)
   find_package(StaticGLEW)
-  add_lv2_ui(${name} ${ARGN})
+  add_lv2_ui(${name} ${ARGN}
+    "${PROJECT_SOURCE_DIR}/sources/framework/idle.cc")
   target_include_directories(${name} PRIVATE ${GLEW_INCLUDE_DIRS})
   if(StaticGLEW_FOUND)
     target_compile_definitions(${name} PRIVATE ${StaticGLEW_DEFINITIONS})
@@ -141,10 +214,118 @@ endmacro()
 
 macro(add_lv2_nvgui name)
   include(TargetNanoVG)
-  add_lv2_glui(${name} ${ARGN})
+  add_lv2_glui(${name} ${ARGN}
+    "${PROJECT_SOURCE_DIR}/sources/framework/nvgbackend.cc"
+    "${PROJECT_SOURCE_DIR}/sources/framework/nvgfontatlas.cc"
+    "${PROJECT_SOURCE_DIR}/sources/framework/nvglayer.cc")
   target_link_libraries(${name} nanovg)
 endmacro()
 
+# compile the glyphs of fonts into the target, prebaked at build time
+# the arguments are quadruplets: <face> <font-file> <size> <codepoint-ranges>
+macro(target_lv2_font_atlas name)
+  set(_atlas_source "${CMAKE_CURRENT_BINARY_DIR}/${name}_fontatlas.cc")
+  if(CMAKE_CROSSCOMPILING)
+    # the generator does not run on the build machine, all text falls back
+    file(WRITE "${_atlas_source}" "#include \"framework/fontatlas.h\"
+const FontAtlasData &font_atlas_data() {
+  static const FontAtlasData data = {};
+  return data;
+}
+")
+  else()
+    if(NOT TARGET makefontatlas)
+      add_executable(makefontatlas tools/makefontatlas.cc)
+      target_include_directories(makefontatlas
+        PRIVATE "${PROJECT_SOURCE_DIR}/thirdparty/nanovg/src")
+    endif()
+    set(_atlas_args)
+    set(_atlas_depends)
+    set(_atlas_field 0)
+    foreach(_arg ${ARGN})
+      if(_atlas_field EQUAL 1)
+        if(NOT IS_ABSOLUTE "${_arg}")
+          set(_arg "${CMAKE_CURRENT_SOURCE_DIR}/${_arg}")
+        endif()
+        list(APPEND _atlas_depends "${_arg}")
+      endif()
+      list(APPEND _atlas_args "${_arg}")
+      math(EXPR _atlas_field "(${_atlas_field} + 1) % 4")
+    endforeach()
+    add_custom_command(
+      OUTPUT "${_atlas_source}"
+      COMMAND makefontatlas "${_atlas_source}" ${_atlas_args}
+      DEPENDS makefontatlas ${_atlas_depends}
+      COMMENT "Generating the font atlas of ${name}")
+  endif()
+  target_sources(${name} PRIVATE "${_atlas_source}")
+  target_include_directories(${name} PRIVATE "${PROJECT_SOURCE_DIR}/sources")
+endmacro()
+
+# headless benchmark of the NanoVG rendering, on an offscreen EGL surface
+# the sources are the drawing code of the UI, without its window
+macro(add_lv2_uibench name)
+  include(FindPkgConfig)
+  pkg_check_modules(EGL egl)
+  if(CMAKE_CROSSCOMPILING)
+    message(STATUS "Cross compiling, the UI benchmark is disabled")
+  elseif(NOT EGL_FOUND)
+    message(STATUS "EGL not found, the UI benchmark is disabled")
+  else()
+    if(NOT TARGET nanovg)
+      include(TargetNanoVG)
+    endif()
+    find_package(GLEW REQUIRED)
+    find_package(StaticGLEW)
+    add_executable(${name}
+      tools/uibench.cc
+      ${ARGN}
+      "${PROJECT_SOURCE_DIR}/sources/framework/nvgbackend.cc"
+      "${PROJECT_SOURCE_DIR}/sources/framework/nvgfontatlas.cc"
+      "${PROJECT_SOURCE_DIR}/sources/framework/nvglayer.cc"
+      "${PROJECT_SOURCE_DIR}/sources/framework/telemetry.cc")
+    target_lv2_kernels(${name})
+    target_include_directories(${name}
+      PRIVATE "${PROJECT_SOURCE_DIR}/sources"
+      PRIVATE ${LV2_INCLUDE_DIRS}
+      PRIVATE ${Boost_INCLUDE_DIRS}
+      PRIVATE ${GLEW_INCLUDE_DIRS}
+      PRIVATE ${EGL_INCLUDE_DIRS})
+    if(StaticGLEW_FOUND)
+      target_compile_definitions(${name} PRIVATE ${StaticGLEW_DEFINITIONS})
+      target_link_libraries(${name} ${StaticGLEW_LIBRARIES})
+    else()
+      target_link_libraries(${name} ${GLEW_LIBRARIES})
+    endif()
+    target_link_libraries(${name} nanovg ${EGL_LIBRARIES})
+  endif()
+endmacro()
+
+# test of the Turtle writer and of the manifest of an effect target, which
+# are checked with the parser of serd
+macro(add_lv2_manifest_test name fx)
+  include(FindPkgConfig)
+  pkg_check_modules(SERD serd-0)
+  if(CMAKE_CROSSCOMPILING)
+    message(STATUS "Cross compiling, the manifest test is disabled")
+  elseif(NOT SERD_FOUND)
+    message(STATUS "serd not found, the manifest test is disabled")
+  else()
+    add_executable(${name}
+      tests/manifesttest.cc
+      "${PROJECT_SOURCE_DIR}/sources/framework/turtle.cc")
+    target_include_directories(${name}
+      PRIVATE "${PROJECT_SOURCE_DIR}/sources"
+      PRIVATE ${Boost_INCLUDE_DIRS}
+      PRIVATE ${SERD_INCLUDE_DIRS})
+    target_link_libraries(${name} ${SERD_LIBRARIES})
+    if(CMAKE_SYSTEM_NAME MATCHES "Linux")
+      target_link_libraries(${name} dl)
+    endif()
+    add_test(NAME ${name} COMMAND ${name} $<TARGET_FILE:${fx}>)
+  endif()
+endmacro()
+
 macro(add_lv2_tkui name)
   find_package(TCL)
   if(NOT TCLTK_FOUND)
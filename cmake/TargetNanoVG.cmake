@@ -4,29 +4,17 @@ set(NANOVG_SOURCE_DIR
 option(NANOVG_USE_FREETYPE "Whether NanoVG should use Freetype" OFF)
 option(NANOVG_USE_GLEW "Whether NanoVG should use GLEW" ON)
 
-if(NOT NANOVG_GL_VERSION)
-  set(NANOVG_GL_VERSION "GL2" CACHE STRING "OpenGL version for NanoVG")
-endif()
-
-add_library(nanovg STATIC "${CMAKE_CURRENT_LIST_DIR}/TargetNanoVG_impl.c")
+# both OpenGL backends are built, and the UI selects one at run time
+add_library(nanovg STATIC
+  "${CMAKE_CURRENT_LIST_DIR}/TargetNanoVG_impl.c"
+  "${CMAKE_CURRENT_LIST_DIR}/TargetNanoVG_gl2.c"
+  "${CMAKE_CURRENT_LIST_DIR}/TargetNanoVG_gl3.c")
 target_include_directories(nanovg PUBLIC "${NANOVG_SOURCE_DIR}/src")
 
 find_package(OpenGL REQUIRED)
 target_link_libraries(nanovg ${OPENGL_LIBRARIES})
 target_include_directories(nanovg PUBLIC "${OPENGL_INCLUDE_DIR}")
 
-if(NANOVG_GL_VERSION STREQUAL "GL2")
-  target_compile_definitions(nanovg
-    PUBLIC "NANOVG_GL2=1"
-    PRIVATE "NANOVG_GL2_IMPLEMENTATION=1")
-elseif(NANOVG_GL_VERSION STREQUAL "GL3")
-  target_compile_definitions(nanovg
-    PUBLIC "NANOVG_GL3=1"
-    PRIVATE "NANOVG_GL3_IMPLEMENTATION=1")
-else()
-  message(FATAL_ERROR "unknown OpenGL requested version '${NANOVG_GL_VERSION}'")
-endif()
-
 if(NANOVG_USE_FREETYPE)
   find_package(Freetype REQUIRED)
   target_compile_definitions(nanovg PRIVATE "FONS_USE_FREETYPE=1")
@@ -0,0 +1,46 @@
+/* OpenGL backend of NanoVG, included with NANOVG_GL2 or NANOVG_GL3 defined.
+   The utilities of nanovg_gl_utils.h depend on the backend, so they are
+   renamed with the suffix of the version.
+   The implementation is requested by version, since nanovg_gl.h derives the
+   options of the backend from it, such as uniform buffers for GL3. */
+
+# if defined(_WIN32)
+#  include <windows.h>
+# endif
+
+#if defined(NANOVG_GLEW)
+# include <GL/glew.h>
+#else
+# define GL_GLEXT_PROTOTYPES 1
+#endif
+
+#if defined(__APPLE__)
+# include <OpenGL/gl.h>
+# include <OpenGL/glext.h>
+#else
+# include <GL/gl.h>
+# include <GL/glext.h>
+#endif
+
+#include <nanovg.h>
+
+#if defined(NANOVG_GL2)
+# if defined(NANOVG_GLEW)
+/* framebuffer objects are loaded by GLEW */
+#  define NANOVG_FBO_VALID 1
+# endif
+# define nvgluBindFramebuffer nvgluBindFramebufferGL2
+# define nvgluCreateFramebuffer nvgluCreateFramebufferGL2
+# define nvgluDeleteFramebuffer nvgluDeleteFramebufferGL2
+# define NANOVG_GL2_IMPLEMENTATION 1
+#elif defined(NANOVG_GL3)
+# define nvgluBindFramebuffer nvgluBindFramebufferGL3
+# define nvgluCreateFramebuffer nvgluCreateFramebufferGL3
+# define nvgluDeleteFramebuffer nvgluDeleteFramebufferGL3
+# define NANOVG_GL3_IMPLEMENTATION 1
+#else
+# error "unknown OpenGL version"
+#endif
+
+#include <nanovg_gl.h>
+#include <nanovg_gl_utils.h>
@@ -0,0 +1,2 @@
+#define NANOVG_GL2 1
+#include "TargetNanoVG_gl.h"
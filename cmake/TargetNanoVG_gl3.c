@@ -0,0 +1,2 @@
+#define NANOVG_GL3 1
+#include "TargetNanoVG_gl.h"
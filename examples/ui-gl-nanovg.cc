@@ -1,10 +1,11 @@
 #include "framework/ui.h"
+#include "framework/idle.h"
+#include "framework/nvgbackend.h"
 #include "meta/project.h"
 #include <GL/glew.h>
 #include <pugl/gl.h>
 #include <pugl/pugl.h>
 #include <nanovg.h>
-#include <nanovg_gl.h>
 #include <boost/scope_exit.hpp>
 #include <stdexcept>
 #include <iostream>
@@ -16,11 +17,21 @@ struct UI::Impl {
   PuglView *view {};
   PuglNativeWindow parent = 0;
   PuglNativeWindow widget = 0;
+  LV2UI_Resize *resize {};
+  float scale = 1;
+  const NvgBackend *nvg {};
   NVGcontext *vg {};
+  IdleScheduler scheduler;
   bool exposed = false;
   bool initialized_nvg = false;
-  bool needs_redraw = true;
+  struct {
+    LV2_URID atom_float;
+    LV2_URID scale_factor;
+  } urid;
+  unsigned pixel_width() const;
+  unsigned pixel_height() const;
   void create_widget();
+  void set_scale_factor(float scale);
   void handle_event(const PuglEvent *event);
   void init_nvg();
   void draw_nvg();
@@ -30,19 +41,28 @@ struct UI::Impl {
 
 //==============================================================================
 UI::UI(void *parent, LV2_URID_Map *map, LV2_URID_Unmap *unmap,
-       const char *bundle_path)
+       const char *bundle_path, TelemetryChannel *telemetry, LV2UI_Resize *resize)
     : P(new Impl) {
   P->parent = PuglNativeWindow(parent);
+  P->resize = resize;
+  P->urid.atom_float = map->map(map->handle, LV2_ATOM__Float);
+  P->urid.scale_factor = map->map(map->handle, LV2_UI__scaleFactor);
 }
 
 UI::~UI() {
   if (P->vg)
-    nvgDeleteGL2(P->vg);
+    P->nvg->destroy(P->vg);
   if (P->view)
     puglDestroy(P->view);
 }
 
-void UI::option(const LV2_Options_Option &o) {
+void UI::option(const LV2_Options_Option &option) {
+  const auto urid = P->urid;
+
+  if (option.key == urid.scale_factor) {
+    if (option.type == urid.atom_float && option.size == sizeof(float))
+      P->set_scale_factor(*reinterpret_cast<const float *>(option.value));
+  }
 }
 
 LV2UI_Widget UI::widget() const {
@@ -51,12 +71,12 @@ LV2UI_Widget UI::widget() const {
   return LV2UI_Widget(P->widget);
 }
 
-unsigned UI::width() {
-  return Impl::width;
+unsigned UI::width() const {
+  return P->pixel_width();
 }
 
-unsigned UI::height() {
-  return Impl::height;
+unsigned UI::height() const {
+  return P->pixel_height();
 }
 
 void UI::port_event(
@@ -72,13 +92,16 @@ bool UI::idle() {
   if (!view)
     return false;
 
-  puglProcessEvents(view);
+  IdleScheduler &scheduler = P->scheduler;
+  if (scheduler.events_pending())
+    puglProcessEvents(view);
   if (!P->exposed)
     return false;
 
   if (!P->initialized_nvg) {
     puglEnterContext(view);
     P->init_nvg();
+    scheduler.attach_current_display();
     P->initialized_nvg = true;
     puglLeaveContext(view, false);
   }
@@ -87,11 +110,10 @@ bool UI::idle() {
   if (!vg)
     return false;
 
-  if (P->needs_redraw) {
+  if (scheduler.should_redraw()) {
     puglEnterContext(view);
     P->draw_nvg();
     puglLeaveContext(view, true);
-    P->needs_redraw = false;
   }
   return true;
 }
@@ -118,7 +140,7 @@ void UI::Impl::create_widget() {
     reinterpret_cast<UI::Impl *>(puglGetHandle(view))->handle_event(event); });
 
   puglInitWindowParent(view, this->parent);
-  puglInitWindowSize(view, Impl::width, Impl::height);
+  puglInitWindowSize(view, this->pixel_width(), this->pixel_height());
   puglInitResizable(view, false);
   puglInitContextType(view, PUGL_GL);
 
@@ -135,13 +157,35 @@ void UI::Impl::create_widget() {
 
 void UI::Impl::handle_event(const PuglEvent *event) {
   switch (event->type) {
-    case PUGL_EXPOSE: this->exposed = true; this->needs_redraw = true; break;
+    case PUGL_EXPOSE: this->exposed = true; update(); break;
     case PUGL_CLOSE: this->exposed = false; break;
     // handle other events here, invoke update() to make the screen redraw
     default: break;
   }
 }
 
+unsigned UI::Impl::pixel_width() const {
+  return unsigned(std::lround(Impl::width * this->scale));
+}
+
+unsigned UI::Impl::pixel_height() const {
+  return unsigned(std::lround(Impl::height * this->scale));
+}
+
+void UI::Impl::set_scale_factor(float scale) {
+  if (!(scale > 0) || scale == this->scale)
+    return;
+
+  this->scale = scale;
+
+  // if the window exists, ask the host to resize it
+  if (this->view) {
+    if (this->resize)
+      this->resize->ui_resize(this->resize->handle, pixel_width(), pixel_height());
+    update();
+  }
+}
+
 #include "../resources/Roboto-Regular.ttf.c"
 #include "../resources/Roboto-Bold.ttf.c"
 
@@ -151,13 +195,15 @@ void UI::Impl::init_nvg() {
     return;
   }
 
-  NVGcontext *vg = this->vg = nvgCreateGL2(NVG_ANTIALIAS|NVG_STENCIL_STROKES);
+  const NvgBackend &nvg = *(this->nvg = &nvg_backend());
+  NVGcontext *vg = this->vg = nvg.create(nvg_antialias|nvg_stencil_strokes);
   if (!vg) {
     std::cerr << "error creating a NanoVG context\n";
     return;
   }
 
   Impl::print_gl_info(std::cerr);
+  std::cerr << "NanoVG backend: " << nvg.name << "\n";
 
   nvgCreateFontMem(
       vg, "sans",
@@ -170,12 +216,12 @@ void UI::Impl::init_nvg() {
 }
 
 void UI::Impl::draw_nvg() {
-  glViewport(0, 0, Impl::width, Impl::height);
+  glViewport(0, 0, pixel_width(), pixel_height());
   glClearColor(0, 0, 0, 0);
   glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT|GL_STENCIL_BUFFER_BIT);
 
   NVGcontext *vg = this->vg;
-  nvgBeginFrame(vg, Impl::width, Impl::height, 1);
+  nvgBeginFrame(vg, Impl::width, Impl::height, this->scale);
 
   // text drawing example
   {
@@ -248,7 +294,7 @@ void UI::Impl::draw_nvg() {
 }
 
 void UI::Impl::update() {
-  this->needs_redraw = true;
+  this->scheduler.request_redraw();
 }
 
 void UI::Impl::print_gl_info(std::ostream &os) {
@@ -1,4 +1,5 @@
 #include "framework/ui.h"
+#include "framework/idle.h"
 #include "meta/project.h"
 #include <GL/glew.h>
 #include <pugl/gl.h>
@@ -6,6 +7,7 @@
 #include <boost/scope_exit.hpp>
 #include <stdexcept>
 #include <iostream>
+#include <cmath>
 
 struct UI::Impl {
   static constexpr unsigned width = 600;
@@ -13,10 +15,20 @@ struct UI::Impl {
   PuglView *view {};
   PuglNativeWindow parent = 0;
   PuglNativeWindow widget = 0;
+  LV2UI_Resize *resize {};
+  float scale = 1;
+  IdleScheduler scheduler;
   bool exposed = false;
   bool initialized_gl = false;
   bool ok_gl = false;
+  struct {
+    LV2_URID atom_float;
+    LV2_URID scale_factor;
+  } urid;
+  unsigned pixel_width() const;
+  unsigned pixel_height() const;
   void create_widget();
+  void set_scale_factor(float scale);
   void handle_event(const PuglEvent *event);
   void init_gl();
   void draw_gl();
@@ -24,9 +36,12 @@ struct UI::Impl {
 
 //==============================================================================
 UI::UI(void *parent, LV2_URID_Map *map, LV2_URID_Unmap *unmap,
-       const char *bundle_path)
+       const char *bundle_path, TelemetryChannel *telemetry, LV2UI_Resize *resize)
     : P(new Impl) {
   P->parent = PuglNativeWindow(parent);
+  P->resize = resize;
+  P->urid.atom_float = map->map(map->handle, LV2_ATOM__Float);
+  P->urid.scale_factor = map->map(map->handle, LV2_UI__scaleFactor);
 }
 
 UI::~UI() {
@@ -34,7 +49,13 @@ UI::~UI() {
     puglDestroy(P->view);
 }
 
-void UI::option(const LV2_Options_Option &o) {
+void UI::option(const LV2_Options_Option &option) {
+  const auto urid = P->urid;
+
+  if (option.key == urid.scale_factor) {
+    if (option.type == urid.atom_float && option.size == sizeof(float))
+      P->set_scale_factor(*reinterpret_cast<const float *>(option.value));
+  }
 }
 
 LV2UI_Widget UI::widget() const {
@@ -43,12 +64,12 @@ LV2UI_Widget UI::widget() const {
   return LV2UI_Widget(P->widget);
 }
 
-unsigned UI::width() {
-  return Impl::width;
+unsigned UI::width() const {
+  return P->pixel_width();
 }
 
-unsigned UI::height() {
-  return Impl::height;
+unsigned UI::height() const {
+  return P->pixel_height();
 }
 
 void UI::port_event(
@@ -64,11 +85,14 @@ bool UI::idle() {
   if (!view)
     return false;
 
-  puglProcessEvents(view);
+  IdleScheduler &scheduler = P->scheduler;
+  if (scheduler.events_pending())
+    puglProcessEvents(view);
 
   if (!P->initialized_gl) {
     puglEnterContext(view);
     P->init_gl();
+    scheduler.attach_current_display();
     P->initialized_gl = true;
     puglLeaveContext(view, false);
   }
@@ -76,9 +100,12 @@ bool UI::idle() {
   if (!P->ok_gl)
     return false;
 
-  puglEnterContext(view);
-  P->draw_gl();
-  puglLeaveContext(view, true);
+  // the drawing is static, redraw only when exposed
+  if (scheduler.should_redraw()) {
+    puglEnterContext(view);
+    P->draw_gl();
+    puglLeaveContext(view, true);
+  }
 
   return P->exposed;
 }
@@ -105,7 +132,7 @@ void UI::Impl::create_widget() {
     reinterpret_cast<UI::Impl *>(puglGetHandle(view))->handle_event(event); });
 
   puglInitWindowParent(view, this->parent);
-  puglInitWindowSize(view, Impl::width, Impl::height);
+  puglInitWindowSize(view, this->pixel_width(), this->pixel_height());
   puglInitResizable(view, false);
   puglInitContextType(view, PUGL_GL);
 
@@ -122,13 +149,35 @@ void UI::Impl::create_widget() {
 
 void UI::Impl::handle_event(const PuglEvent *event) {
   switch (event->type) {
-    case PUGL_EXPOSE: this->exposed = true; break;
+    case PUGL_EXPOSE: this->exposed = true; this->scheduler.request_redraw(); break;
     case PUGL_CLOSE: this->exposed = false; break;
     // handle other events here
     default: break;
   }
 }
 
+unsigned UI::Impl::pixel_width() const {
+  return unsigned(std::lround(Impl::width * this->scale));
+}
+
+unsigned UI::Impl::pixel_height() const {
+  return unsigned(std::lround(Impl::height * this->scale));
+}
+
+void UI::Impl::set_scale_factor(float scale) {
+  if (!(scale > 0) || scale == this->scale)
+    return;
+
+  this->scale = scale;
+
+  // if the window exists, ask the host to resize it
+  if (this->view) {
+    if (this->resize)
+      this->resize->ui_resize(this->resize->handle, pixel_width(), pixel_height());
+    this->scheduler.request_redraw();
+  }
+}
+
 void UI::Impl::init_gl() {
   if (glewInit() != GLEW_OK) {
     std::cerr << "error initializing GLEW\n";
@@ -136,12 +185,14 @@ void UI::Impl::init_gl() {
   }
 
   glClearColor(0, 0, 0, 0);
-  glViewport(0, 0, Impl::width, Impl::height);
 
   this->ok_gl = true;
 }
 
 void UI::Impl::draw_gl() {
+  // the viewport is in device pixels, the projection in units
+  glViewport(0, 0, pixel_width(), pixel_height());
+
   glMatrixMode(GL_PROJECTION);
   glLoadIdentity();
   glOrtho(0, Impl::width, Impl::height, 0, -10, 10);
@@ -10,7 +10,7 @@ struct UI::Impl {
 
 //==============================================================================
 UI::UI(void *parent, LV2_URID_Map *map, LV2_URID_Unmap *unmap,
-       const char *bundle_path)
+       const char *bundle_path, TelemetryChannel *telemetry, LV2UI_Resize *resize)
     : P(new Impl) {
 }
 
@@ -26,11 +26,11 @@ LV2UI_Widget UI::widget() const {
   return LV2UI_Widget(P->widget);
 }
 
-unsigned UI::width() {
+unsigned UI::width() const {
   return Impl::width;
 }
 
-unsigned UI::height() {
+unsigned UI::height() const {
   return Impl::height;
 }
 
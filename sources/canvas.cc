@@ -0,0 +1,256 @@
+#include "canvas.h"
+#include "framework/nvgbackend.h"
+#include "framework/nvglayer.h"
+#include "framework/nvgfontatlas.h"
+#include "framework/fontatlas.h"
+#include "framework/telemetry.h"
+#include <GL/glew.h>
+#include <nanovg.h>
+#include <algorithm>
+#include <iostream>
+#include <cstdio>
+#include <cmath>
+
+struct Canvas::Impl {
+  static constexpr float plot_w = width * 0.9f, plot_h = 150;
+  static constexpr float plot_x = (width - plot_w) / 2, plot_y = 200;
+  const NvgBackend *nvg {};
+  NVGcontext *vg {};
+  float pixel_ratio = 1;
+  // cached layers, invalidate them to repaint their content
+  NvgLayer background;
+  NvgLayer plot;
+  NvgFontAtlas fonts;
+  NvgReadout voices {fonts, "sans", 12, 4};
+  std::unique_ptr<TelemetryReader> telemetry;
+  TelemetryChannel *telemetry_channel = nullptr;
+  void paint_background(NVGcontext *vg);
+  void paint_plot(NVGcontext *vg);
+  void draw_telemetry(float x, float y, float w, float h);
+};
+
+#include "../resources/Roboto-Regular.ttf.c"
+#include "../resources/Roboto-Bold.ttf.c"
+
+//==============================================================================
+constexpr unsigned Canvas::width;
+constexpr unsigned Canvas::height;
+
+Canvas::Canvas(LV2_URID_Map *map, TelemetryChannel *telemetry)
+    : P(new Impl) {
+  P->telemetry.reset(new TelemetryReader(map));
+  P->telemetry_channel = telemetry;
+  P->fonts.add_fallback("sans", Roboto_Regular_ttf, sizeof(Roboto_Regular_ttf));
+  P->fonts.add_fallback("sans-bold", Roboto_Bold_ttf, sizeof(Roboto_Bold_ttf));
+}
+
+Canvas::~Canvas() {
+}
+
+bool Canvas::init(const NvgBackend &backend) {
+  NVGcontext *vg = backend.create(nvg_antialias|nvg_stencil_strokes);
+  if (!vg) {
+    std::cerr << "error creating a NanoVG context\n";
+    return false;
+  }
+
+  P->nvg = &backend;
+  P->vg = vg;
+
+  // the text in the prebaked atlas is ready, the fonts load only if needed
+  P->fonts.init(vg, font_atlas_data());
+  return true;
+}
+
+void Canvas::cleanup() {
+  if (!P->vg)
+    return;
+  P->background.release();
+  P->plot.release();
+  P->nvg->destroy(P->vg);
+  P->vg = nullptr;
+}
+
+void Canvas::draw() {
+  NVGcontext *vg = P->vg;
+  if (!vg)
+    return;
+
+  // render the invalid layers, before the frame
+  // the layers are painted again only if the pixel ratio changed
+  const float ratio = P->pixel_ratio;
+  P->background.resize(width, height, ratio);
+  P->background.update(*P->nvg, vg, [this](NVGcontext *vg) { P->paint_background(vg); });
+  P->plot.resize(Impl::plot_w + 16, Impl::plot_h + 16, ratio);
+  P->plot.update(*P->nvg, vg, [this](NVGcontext *vg) { P->paint_plot(vg); });
+
+  glViewport(0, 0, pixel_width(), pixel_height());
+  glClearColor(0, 0, 0, 0);
+  glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT|GL_STENCIL_BUFFER_BIT);
+
+  nvgBeginFrame(vg, width, height, ratio);
+
+  // without framebuffers, the layers are painted in the frame
+  P->background.draw_or_paint(vg, 0, 0, [this](NVGcontext *vg) { P->paint_background(vg); });
+  P->plot.draw_or_paint(vg, Impl::plot_x - 8, Impl::plot_y - 8, [this](NVGcontext *vg) { P->paint_plot(vg); });
+  P->draw_telemetry(width * 0.05f, 364, width * 0.9f, 28);
+
+  nvgEndFrame(vg);
+}
+
+void Canvas::set_pixel_ratio(float ratio) {
+  ratio = std::max(ratio, 0.25f);
+  P->pixel_ratio = ratio;
+  P->fonts.set_pixel_ratio(ratio);
+}
+
+float Canvas::pixel_ratio() const {
+  return P->pixel_ratio;
+}
+
+unsigned Canvas::pixel_width() const {
+  return unsigned(std::lround(width * P->pixel_ratio));
+}
+
+unsigned Canvas::pixel_height() const {
+  return unsigned(std::lround(height * P->pixel_ratio));
+}
+
+bool Canvas::port_event(
+    uint32_t port_index, uint32_t buffer_size, uint32_t format, const void *buffer) {
+  // without the direct channel, read the telemetry from the atom port
+  return !P->telemetry_channel && P->telemetry->read(format, buffer_size, buffer);
+}
+
+bool Canvas::fetch() {
+  return P->telemetry_channel && P->telemetry_channel->fetch();
+}
+
+//==============================================================================
+void Canvas::Impl::paint_background(NVGcontext *vg) {
+  // text drawing example
+  {
+    nvgSave(vg);
+
+    float w = 400, h = 100;
+    float x = (width - w) / 2, y = 50;
+
+    nvgStrokeColor(vg, nvgRGB(200, 200, 200));
+    nvgFillColor(vg, nvgRGB(100, 100, 100));
+    nvgStrokeWidth(vg, 10);
+
+    nvgBeginPath(vg);
+    nvgRoundedRect(vg, x, y, w, h, 20);
+    nvgFill(vg);
+    nvgStroke(vg);
+
+    fonts.text_box(vg, "sans-bold", 64, NVG_ALIGN_CENTER|NVG_ALIGN_MIDDLE,
+                   nvgRGB(200, 200, 200), x, y + h / 2, w, "Hello, LV2!");
+
+    nvgRestore(vg);
+  }
+
+  // plot frame
+  {
+    nvgBeginPath(vg);
+    nvgRect(vg, plot_x - 8, plot_y - 8, plot_w + 16, plot_h + 16);
+    nvgFillColor(vg, nvgRGB(50, 50, 50));
+    nvgFill(vg);
+  }
+}
+
+void Canvas::Impl::paint_plot(NVGcontext *vg) {
+  // plot drawing example, in the coordinates of the layer
+  nvgSave(vg);
+
+  constexpr float pi = M_PI;
+
+  float w = plot_w, h = plot_h;
+  float x = 8, y = 8;
+
+  constexpr unsigned nsamples = 64;
+  float samples[nsamples];
+  float sx[nsamples], sy[nsamples];
+  float dx = w / (nsamples - 1);
+
+  for (unsigned i = 0; i < nsamples; ++i) {
+    float x = 4 * ((2 * i / float(nsamples - 1)) - 1);
+    samples[i] = (x == 0) ? 1 : (std::sin(pi * x) / (pi * x));
+  }
+
+  for (unsigned i = 0; i < nsamples; ++i) {
+    float v = (samples[i] + 0.25f) / 1.25f;
+    sx[i] = x + i * dx;
+    sy[i] = y + h * (1 - v);
+  }
+
+  nvgBeginPath(vg);
+  nvgMoveTo(vg, sx[0], sy[0]);
+  for (unsigned i = 1; i < nsamples; i++)
+    nvgQuadTo(vg, (sx[i] + sx[i-1]) / 2, (sy[i] + sy[i-1]) / 2, sx[i], sy[i]);
+  nvgStrokeColor(vg, nvgRGB(255, 200, 0));
+  nvgStrokeWidth(vg, 3.0f);
+  nvgStroke(vg);
+
+  nvgRestore(vg);
+}
+
+void Canvas::Impl::draw_telemetry(float x, float y, float w, float h) {
+  NVGcontext *vg = this->vg;
+  const TelemetryState &state = this->telemetry_channel ?
+      this->telemetry_channel->front() : this->telemetry->state();
+
+  nvgSave(vg);
+
+  nvgBeginPath(vg);
+  nvgRect(vg, x, y, w, h);
+  nvgFillColor(vg, nvgRGB(50, 50, 50));
+  nvgFill(vg);
+
+  // level meters, peak over RMS, on a scale of -60 to 0 dB
+  float mw = w * 0.4f;
+  unsigned nchannels = state.channels;
+  for (unsigned c = 0; c < nchannels; ++c) {
+    float mh = h / nchannels;
+    float my = y + c * mh;
+    auto meter_width = [mw](float level) -> float {
+      float db = 20 * std::log10(std::min(std::max(level, 1e-3f), 1.0f));
+      return mw * (1 + db / 60);
+    };
+    nvgBeginPath(vg);
+    nvgRect(vg, x, my + 1, meter_width(state.peak[c]), mh - 2);
+    nvgFillColor(vg, nvgRGB(0, 120, 60));
+    nvgFill(vg);
+    nvgBeginPath(vg);
+    nvgRect(vg, x, my + 1, meter_width(state.rms[c]), mh - 2);
+    nvgFillColor(vg, nvgRGB(0, 200, 100));
+    nvgFill(vg);
+  }
+
+  // scope of the first channel
+  float sx = x + mw + 8, sw = w - mw - 8;
+  float dx = sw / (telemetry_scope_size - 1);
+  nvgBeginPath(vg);
+  for (unsigned i = 0; i < telemetry_scope_size; ++i) {
+    float v = std::max(-1.0f, std::min(1.0f, state.scope[i]));
+    float px = sx + i * dx, py = y + h * 0.5f * (1 - v);
+    if (i == 0)
+      nvgMoveTo(vg, px, py);
+    else
+      nvgLineTo(vg, px, py);
+  }
+  nvgStrokeColor(vg, nvgRGB(255, 200, 0));
+  nvgStrokeWidth(vg, 1.0f);
+  nvgStroke(vg);
+
+  // the count of voices, in a readout which updates the changed digits only
+  const char *label = " voices";
+  float lx = x + w - 2 - fonts.text_width(vg, "sans", 12, label);
+  fonts.text(vg, "sans", 12, NVG_ALIGN_LEFT|NVG_ALIGN_TOP, nvgRGB(200, 200, 200), lx, y + 2, label);
+  char text[16];
+  std::snprintf(text, sizeof(text), "%u", state.voices);
+  voices.set(text);
+  voices.draw(vg, NVG_ALIGN_RIGHT|NVG_ALIGN_TOP, nvgRGB(200, 200, 200), lx, y + 2);
+
+  nvgRestore(vg);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "framework/lv2all.h"
+#include <memory>
+#include <cstdint>
+struct NvgBackend;
+class TelemetryChannel;
+
+// Drawing of the UI with NanoVG, independent of the window system
+//
+// The functions marked [GL] require the GL context to be current.
+class Canvas {
+ public:
+  // `telemetry` is the direct channel from the effect, or null if unavailable
+  Canvas(LV2_URID_Map *map, TelemetryChannel *telemetry);
+  ~Canvas();
+
+  static constexpr unsigned width = 600;
+  static constexpr unsigned height = 400;
+
+  // [GL] create the NanoVG context and load the fonts, return false on failure
+  bool init(const NvgBackend &backend);
+  // [GL] delete the layers and the NanoVG context
+  void cleanup();
+  // [GL] draw a frame on the current framebuffer, of the size in pixels
+  void draw();
+
+  // set the ratio of device pixels to units, the scale factor of the display
+  void set_pixel_ratio(float ratio);
+  float pixel_ratio() const;
+  // the size of the frame in device pixels
+  unsigned pixel_width() const;
+  unsigned pixel_height() const;
+
+  // read the telemetry from an event of the output port, return true if changed
+  bool port_event(
+      uint32_t port_index, uint32_t buffer_size, uint32_t format, const void *buffer);
+  // fetch the telemetry from the direct channel, return true if changed
+  bool fetch();
+
+ private:
+  struct Impl;
+  const std::unique_ptr<Impl> P;
+};
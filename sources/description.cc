@@ -1,61 +1,94 @@
 #include "framework/description.h"
+#include "framework/telemetry.h"
 #include "framework/lv2all.h"
+#include "variants.h"
 
-static EffectManifest create_effect_manifest() {
-  EffectManifest m;
-  m.uri = effect_uri;
-  m.name = PROJECT_DISPLAY_NAME;
-
-  // set effect categories (superclasses other than lv2:Plugin)
-  m.categories.push_back(LV2_CORE__InstrumentPlugin);
-
-  // request features
-  m.features.push_back(FeatureRequest{LV2_URID__map, RequiredFeature::Yes});
-  m.features.push_back(FeatureRequest{LV2_URID__unmap, RequiredFeature::Yes});
-
-  // create audio ports
-  for (unsigned i = 0; i < 2; ++i) {
-    std::unique_ptr<AudioPort> p(new AudioPort);
-    p->direction = PortDirection::Output;
-    p->symbol = "audio_output_" + std::to_string(i + 1);
-    p->name = "Audio output " + std::to_string(i + 1);
-    m.ports.emplace_back(std::move(p));
-  }
+//==============================================================================
+// effect categories (superclasses other than lv2:Plugin)
+static constexpr const char *effect_categories[] = {
+  LV2_CORE__InstrumentPlugin,
+};
+
+// requested features
+static constexpr FeatureRequest effect_features[] = {
+  {LV2_URID__map, RequiredFeature::Yes},
+  {LV2_URID__unmap, RequiredFeature::Yes},
+  {LV2_OPTIONS__options, RequiredFeature::Yes},
+  {LV2_BUF_SIZE__boundedBlockLength, RequiredFeature::Yes},
+  {LV2_WORKER__schedule, RequiredFeature::No},
+};
+
+// options
+static constexpr const char *effect_required_options[] = {
+  LV2_BUF_SIZE__maxBlockLength,
+};
+static constexpr const char *effect_supported_options[] = {
+  LV2_BUF_SIZE__sequenceSize,
+};
 
-  // create event ports
-  {
-    std::unique_ptr<EventPort> p(new EventPort);
-    p->direction = PortDirection::Input;
-    p->symbol = "event_input";
-    p->name = "Event input";
-    p->buffer_type = LV2_ATOM__Sequence;
-    p->supports.push_back(LV2_MIDI__MidiEvent);
-    m.ports.emplace_back(std::move(p));
+// extension data
+static constexpr const char *effect_extension_data[] = {
+  LV2_WORKER__interface,
+  telemetry_channel_uri,
+};
+
+// effects, one for each variant
+struct MakeEffectManifest {
+  template <class V> static constexpr EffectManifest make() {
+    return EffectManifest{
+      V::uri(),
+      V::name(),
+      effect_categories,
+      effect_features,
+      effect_required_options,
+      effect_supported_options,
+      effect_extension_data,
+      V::ports::records,
+    };
   }
+};
 
-  return m;
-}
+constexpr ArrayRef<EffectManifest> effect_manifests =
+    VariantTable<EffectManifest, EffectVariantList, MakeEffectManifest>::data;
 
-static boost::optional<UIManifest> create_ui_manifest() {
-  UIManifest m;
-  m.uri = ui_uri;
-  m.effect_uri = effect_uri;
+//==============================================================================
+// requested features
+static constexpr FeatureRequest ui_features[] = {
+  {LV2_URID__map, RequiredFeature::Yes},
+  {LV2_URID__unmap, RequiredFeature::Yes},
+  {LV2_UI__resize, RequiredFeature::No},
+  {LV2_UI__parent, RequiredFeature::No},
+  {LV2_UI__idleInterface, RequiredFeature::Yes},
+  {LV2_OPTIONS__options, RequiredFeature::No},
+  {LV2_INSTANCE_ACCESS_URI, RequiredFeature::No},
+  {LV2_DATA_ACCESS_URI, RequiredFeature::No},
+};
 
-  // [!!!IMPORTANT!!!] set UI class
-  m.uiclass = LV2_UI__PlatformSpecificUI;
+// options
+static constexpr const char *ui_supported_options[] = {
+  LV2_UI__scaleFactor,
+};
 
-  // request features
-  m.features.push_back(FeatureRequest{LV2_URID__map, RequiredFeature::Yes});
-  m.features.push_back(FeatureRequest{LV2_URID__unmap, RequiredFeature::Yes});
-  m.features.push_back(FeatureRequest{LV2_UI__resize, RequiredFeature::No});
-  m.features.push_back(FeatureRequest{LV2_UI__parent, RequiredFeature::No});
-  m.features.push_back(FeatureRequest{LV2_UI__idleInterface, RequiredFeature::Yes});
+// extension data
+static constexpr const char *ui_extension_data[] = {
+  LV2_UI__idleInterface,
+  LV2_OPTIONS__interface,
+};
 
-  // extension data
-  m.extension_data.push_back(LV2_UI__idleInterface);
+// the ports which the UI observes, on each of the effects
+static constexpr PortNotification ui_port_notifications[] = {
+  {"event_output", LV2_ATOM__eventTransfer, nullptr},
+};
 
-  return m;
-}
+static constexpr UIManifest ui_manifest_data = {
+  ui_uri,
+  // [!!!IMPORTANT!!!] set UI class
+  LV2_UI__PlatformSpecificUI,
+  ui_features,
+  ui_supported_options,
+  ui_extension_data,
+  ui_port_notifications,
+};
 
-const EffectManifest effect_manifest = create_effect_manifest();
-const boost::optional<UIManifest> ui_manifest = create_ui_manifest();
+// set to nullptr if the plugin has no UI
+constexpr const UIManifest *ui_manifest = &ui_manifest_data;
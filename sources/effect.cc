@@ -1,54 +1,219 @@
 #include "framework/effect.h"
+#include "framework/buffer.h"
+#include "framework/kernels.h"
+#include "framework/loadmeter.h"
+#include "framework/scheduler.h"
+#include "framework/telemetry.h"
+#include "framework/threadpool.h"
+#include "framework/voices.h"
+#include "framework/worker.h"
 #include "framework/lv2all.h"
+#include "variants.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
 #include <cassert>
 
-struct Effect::Impl {
-  float *port_left = nullptr;
-  float *port_right = nullptr;
-  LV2_Atom_Sequence *port_events = nullptr;
+#if defined(ENABLE_THREAD_POOL)
+static constexpr bool use_thread_pool = true;
+#else
+static constexpr bool use_thread_pool = false;
+#endif
+static constexpr unsigned max_voice_parts = 8;
+static constexpr unsigned min_voices_per_part = 8;
+// the time given to the workers to render their parts, in proportion of the
+// duration of the block, after which the audio thread renders them itself
+static constexpr double voice_parts_timeout = 0.25;
+
+//==============================================================================
+// the effect, specialized for the configuration of a variant
+template <class V>
+class EffectCore final : public Effect {
+ public:
+  EffectCore(double rate, LV2_URID_Map *map, LV2_URID_Unmap *unmap,
+             const char *bundle_path, Worker *worker);
+  ~EffectCore();
+
+  //============================================================================
+  void option(const LV2_Options_Option &o) override;
+  void prepare() override;
+
+  //============================================================================
+  void connect_port(uint32_t port, void *data) override;
+
+  //============================================================================
+  void activate() override;
+  void deactivate() override;
+
+  //============================================================================
+  void run(unsigned nframes) override;
+
+  //============================================================================
+  void work(uint32_t type, const void *data, uint32_t size) override;
+  void work_response(uint32_t type, const void *data, uint32_t size) override;
+
+  //============================================================================
+  TelemetryChannel *telemetry_channel() override;
+
+ private:
+  typedef typename V::sample_type sample_t;
+  typedef typename V::ports ports_t;
+  struct Impl;
+  const std::unique_ptr<Impl> P;
+};
+
+template <class V>
+struct EffectCore<V>::Impl {
+  typename ports_t::Ports ports;
   unsigned in_midi_channel = 0;
+  std::unique_ptr<VoicePool> voices;
+  std::unique_ptr<LoadMeter> load_meter;
+  std::unique_ptr<TelemetryWriter> telemetry;
+  Worker *worker = nullptr;
+  const Kernels *kernels = nullptr;
+  double rate = 0;
+  unsigned max_block_length = 0;
+  unsigned sequence_size = 0;
+  AlignedBuffer<sample_t> mix_buffer;
+  std::shared_ptr<ThreadPool> pool;
+  unsigned num_voice_parts = 1;
+  unsigned part_stride = 0;
+  // the output of each part, in the slots of the worker and the caller
+  AlignedBuffer<sample_t> part_buffers;
+  // the job of the parts, per slot, since a late worker may still read the
+  // one of slot 0 after the run
+  struct {
+    unsigned count = 0;
+    unsigned num_parts = 0;
+  } voice_job[2];
+  sample_t *part_buffer(unsigned part, unsigned slot);
   struct {
     LV2_URID midi_event;
+    LV2_URID atom_int;
+    LV2_URID atom_long;
+    LV2_URID max_block_length;
+    LV2_URID sequence_size;
   } urid;
 };
 
+template <class V>
+auto EffectCore<V>::Impl::part_buffer(unsigned part, unsigned slot) -> sample_t * {
+  return &part_buffers[(slot * num_voice_parts + part) * part_stride];
+}
+
+static bool option_as_uint(const LV2_Options_Option &o, LV2_URID atom_int,
+                           LV2_URID atom_long, unsigned &value);
+
+// mixing in the internal precision, with the vector kernels in single precision
+static void fill_samples(const Kernels &k, float *dst, unsigned n);
+static void fill_samples(const Kernels &k, double *dst, unsigned n);
+static void copy_samples(const Kernels &k, float *dst, const float *src, unsigned n);
+template <class D, class S>
+static void copy_samples(const Kernels &k, D *dst, const S *src, unsigned n);
+static void add_samples(const Kernels &k, float *dst, const float *src, unsigned n);
+static void add_samples(const Kernels &k, double *dst, const double *src, unsigned n);
+
 //==============================================================================
-Effect::Effect(double rate, LV2_URID_Map *map, LV2_URID_Unmap *unmap,
-               const char *bundle_path)
+template <class V>
+EffectCore<V>::EffectCore(double rate, LV2_URID_Map *map, LV2_URID_Unmap *unmap,
+                          const char *bundle_path, Worker *worker)
     : P(new Impl) {
+  P->worker = worker;
+  P->rate = rate;
   P->urid.midi_event = map->map(map->handle, LV2_MIDI__MidiEvent);
+  P->urid.atom_int = map->map(map->handle, LV2_ATOM__Int);
+  P->urid.atom_long = map->map(map->handle, LV2_ATOM__Long);
+  P->urid.max_block_length = map->map(map->handle, LV2_BUF_SIZE__maxBlockLength);
+  P->urid.sequence_size = map->map(map->handle, LV2_BUF_SIZE__sequenceSize);
+  P->voices.reset(new VoicePool(V::max_voices, rate));
+  P->load_meter.reset(new LoadMeter(rate));
+  P->telemetry.reset(new TelemetryWriter(map, rate));
+  P->kernels = &::kernels();
+  if (use_thread_pool) {
+    P->pool = ThreadPool::shared();
+    P->num_voice_parts = std::min(P->pool->concurrency(), max_voice_parts);
+  }
 }
 
-Effect::~Effect() {
+template <class V>
+EffectCore<V>::~EffectCore() {
+  // a late worker may still render the voices, in the buffers of the effect
+  if (ThreadPool *pool = P->pool.get())
+    pool->wait_idle();
 }
 
 //==============================================================================
-void Effect::option(const LV2_Options_Option &o) {
+template <class V>
+void EffectCore<V>::option(const LV2_Options_Option &o) {
+  const auto urid = P->urid;
+
+  if (o.key == urid.max_block_length)
+    option_as_uint(o, urid.atom_int, urid.atom_long, P->max_block_length);
+  else if (o.key == urid.sequence_size)
+    option_as_uint(o, urid.atom_int, urid.atom_long, P->sequence_size);
 }
 
-//==============================================================================
-void Effect::connect_port(uint32_t port, void *data) {
-  switch (port) {
-    case 0: P->port_left = (float *)data; break;
-    case 1: P->port_right = (float *)data; break;
-    case 2: P->port_events = (LV2_Atom_Sequence *)data; break;
-    default: assert(false);
+template <class V>
+void EffectCore<V>::prepare() {
+  unsigned max_block_length = P->max_block_length;
+  if (max_block_length == 0)
+    throw std::runtime_error("the host did not indicate the maximum block length");
+
+  P->mix_buffer.reset(max_block_length);
+
+  // the messages to the UI fit the atom output, if the host indicates its size
+  if (P->sequence_size > 0)
+    P->telemetry->set_capacity(P->sequence_size);
+
+  unsigned num_voice_parts = P->num_voice_parts;
+  if (num_voice_parts > 1) {
+    unsigned stride = (max_block_length + 15) & ~15u;
+    P->part_stride = stride;
+    P->part_buffers.reset(2 * num_voice_parts * stride);
   }
 }
 
 //==============================================================================
-void Effect::activate() {
+template <class V>
+void EffectCore<V>::connect_port(uint32_t port, void *data) {
+  assert(port < ports_t::size);
+  ports_t::connect(P->ports, port, data);
+}
+
+//==============================================================================
+template <class V>
+void EffectCore<V>::activate() {
+  P->voices->all_sounds_off();
+  P->load_meter->reset();
+  P->telemetry->reset();
 }
 
-void Effect::deactivate() {
+template <class V>
+void EffectCore<V>::deactivate() {
+  // no worker still renders the voices of the last run
+  if (ThreadPool *pool = P->pool.get())
+    pool->wait_idle();
 }
 
 //==============================================================================
-void Effect::run(unsigned nframes) {
+template <class V>
+void EffectCore<V>::run(unsigned nframes) {
+  assert(nframes <= P->max_block_length);
+
+  LoadMeter &load_meter = *P->load_meter;
+  load_meter.begin();
+
+  const typename ports_t::Ports &ports = P->ports;
+  const std::array<float *, V::channels> outputs =
+      V::port_layout::audio_outputs(ports);
+
   const auto urid = P->urid;
+  VoicePool &voices = *P->voices;
+  const Kernels &k = *P->kernels;
+  ThreadPool *pool = P->pool.get();
 
-  // TODO put midi code here
-  LV2_ATOM_SEQUENCE_FOREACH(P->port_events, event) {
+  auto process = [&](const LV2_Atom_Event *event) {
+    // TODO put midi code here
     if (event->body.type == urid.midi_event) {
       const uint8_t *msg = (uint8_t *)LV2_ATOM_CONTENTS(LV2_Atom_Event, event);
       uint32_t msglen = event->body.size;
@@ -56,11 +221,159 @@ void Effect::run(unsigned nframes) {
           (lv2_midi_is_voice_message(msg) &&
            (msg[0] & 0xf) == P->in_midi_channel)) {
         // handle the midi message
+        switch (msglen < 3 ? 0 : lv2_midi_message_type(msg)) {
+          case LV2_MIDI_MSG_NOTE_ON:
+            voices.note_on(msg[1] & 0x7f, msg[2] & 0x7f);
+            break;
+          case LV2_MIDI_MSG_NOTE_OFF:
+            voices.note_off(msg[1] & 0x7f);
+            break;
+          case LV2_MIDI_MSG_CONTROLLER:
+            if (msg[1] == LV2_MIDI_CTL_ALL_NOTES_OFF)
+              voices.all_notes_off();
+            else if (msg[1] == LV2_MIDI_CTL_ALL_SOUNDS_OFF)
+              voices.all_sounds_off();
+            break;
+          default:
+            break;
+        }
       }
     }
+  };
+
+  auto render = [&](unsigned offset, unsigned count) {
+    // TODO put audio code here
+    sample_t *mix = P->mix_buffer.data();
+    unsigned num_parts = std::min(
+        P->num_voice_parts, voices.active() / min_voices_per_part);
+    if (num_parts < 2) {
+      fill_samples(k, mix, count);
+      voices.render(mix, count);
+    }
+    else {
+      P->voice_job[1].count = count;
+      P->voice_job[1].num_parts = num_parts;
+      const std::chrono::nanoseconds timeout(
+          int64_t(1e9 * voice_parts_timeout * count / P->rate));
+      uint64_t slots = pool->run([](void *data, unsigned part, unsigned slot) {
+        Impl &self = *reinterpret_cast<Impl *>(data);
+        const unsigned count = self.voice_job[slot].count;
+        sample_t *out = self.part_buffer(part, slot);
+        fill_samples(*self.kernels, out, count);
+        self.voices->render_part(out, count, part, self.voice_job[slot].num_parts, slot);
+      }, [](void *data) {
+        Impl &self = *reinterpret_cast<Impl *>(data);
+        self.voice_job[0] = self.voice_job[1];
+        self.voices->snapshot();
+      }, P.get(), num_parts, timeout);
+      voices.collect(num_parts, slots);
+      copy_samples(k, mix, P->part_buffer(0, slots & 1), count);
+      for (unsigned part = 1; part < num_parts; ++part)
+        add_samples(k, mix, P->part_buffer(part, (slots >> part) & 1), count);
+    }
+    for (unsigned c = 0; c < V::channels; ++c)
+      copy_samples(k, outputs[c] + offset, mix, count);
+  };
+
+  run_sequence(ports.template get<EffectPort::EventInput>(), nframes, render, process);
+
+  // send the analysis of the output to the UI
+  TelemetryWriter &telemetry = *P->telemetry;
+  uint64_t notes[2];
+  voices.held_notes(notes);
+  telemetry.set_voices(voices.active(), notes);
+  telemetry.analyze(outputs.data(), V::channels, nframes);
+  if (LV2_Atom_Sequence *seq = ports.template get<EffectPort::EventOutput>())
+    telemetry.write(seq);
+
+  // report the load, the current one as of the previous cycle
+  if (float *port = ports.template get<EffectPort::DspLoad>())
+    *port = 100 * load_meter.current();
+  if (float *port = ports.template get<EffectPort::DspLoadPeak>())
+    *port = 100 * load_meter.peak();
+  if (float *port = ports.template get<EffectPort::DspLoadP99>())
+    *port = 100 * load_meter.percentile(0.99f);
+
+  load_meter.end(nframes);
+}
+
+//==============================================================================
+template <class V>
+void EffectCore<V>::work(uint32_t type, const void *data, uint32_t size) {
+  // TODO put non-realtime work here, and reply with P->worker->respond()
+}
+
+template <class V>
+void EffectCore<V>::work_response(uint32_t type, const void *data, uint32_t size) {
+  // TODO handle the result of the work here
+}
+
+//==============================================================================
+template <class V>
+TelemetryChannel *EffectCore<V>::telemetry_channel() {
+  return &P->telemetry->channel();
+}
+
+//==============================================================================
+template <class V>
+static Effect *create_effect(double rate, LV2_URID_Map *map, LV2_URID_Unmap *unmap,
+                             const char *bundle_path, Worker *worker) {
+  return new EffectCore<V>(rate, map, unmap, bundle_path, worker);
+}
+
+struct MakeEffectFactory {
+  template <class V> static constexpr EffectFactory *make() {
+    return &create_effect<V>;
   }
+};
+
+constexpr ArrayRef<EffectFactory *> effect_factories =
+    VariantTable<EffectFactory *, EffectVariantList, MakeEffectFactory>::data;
+
+//==============================================================================
+static bool option_as_uint(const LV2_Options_Option &o, LV2_URID atom_int,
+                           LV2_URID atom_long, unsigned &value) {
+  if (o.type == atom_int && o.size == sizeof(int32_t)) {
+    int32_t v = *reinterpret_cast<const int32_t *>(o.value);
+    if (v < 0)
+      return false;
+    value = unsigned(v);
+    return true;
+  }
+  if (o.type == atom_long && o.size == sizeof(int64_t)) {
+    int64_t v = *reinterpret_cast<const int64_t *>(o.value);
+    if (v < 0 || v > UINT32_MAX)
+      return false;
+    value = unsigned(v);
+    return true;
+  }
+  return false;
+}
+
+//==============================================================================
+static void fill_samples(const Kernels &k, float *dst, unsigned n) {
+  k.fill(dst, 0, n);
+}
+
+static void fill_samples(const Kernels &k, double *dst, unsigned n) {
+  std::fill(dst, dst + n, 0.0);
+}
+
+static void copy_samples(const Kernels &k, float *dst, const float *src, unsigned n) {
+  k.copy(dst, src, n);
+}
+
+template <class D, class S>
+static void copy_samples(const Kernels &k, D *dst, const S *src, unsigned n) {
+  for (unsigned i = 0; i < n; ++i)
+    dst[i] = D(src[i]);
+}
+
+static void add_samples(const Kernels &k, float *dst, const float *src, unsigned n) {
+  k.mix(dst, src, 1, n);
+}
 
-  // TODO put audio code here
-  std::fill_n(P->port_left, nframes, 0);
-  std::fill_n(P->port_right, nframes, 0);
+static void add_samples(const Kernels &k, double *dst, const double *src, unsigned n) {
+  for (unsigned i = 0; i < n; ++i)
+    dst[i] += src[i];
 }
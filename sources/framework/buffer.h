@@ -0,0 +1,31 @@
+#pragma once
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+// Buffer of trivial elements, aligned in memory
+template <class T, size_t Alignment = 64>
+class AlignedBuffer {
+ public:
+  AlignedBuffer() {}
+  explicit AlignedBuffer(size_t size) { reset(size); }
+
+  // reallocate and zero-fill; not for use in realtime context
+  void reset(size_t size) {
+    std::unique_ptr<uint8_t[]> storage(new uint8_t[size * sizeof(T) + Alignment - 1]());
+    uintptr_t address = reinterpret_cast<uintptr_t>(storage.get());
+    address = (address + Alignment - 1) & ~uintptr_t(Alignment - 1);
+    data_ = reinterpret_cast<T *>(address);
+    size_ = size;
+    storage_ = std::move(storage);
+  }
+
+  T *data() const { return data_; }
+  size_t size() const { return size_; }
+  T &operator[](size_t i) const { return data_[i]; }
+
+ private:
+  std::unique_ptr<uint8_t[]> storage_;
+  T *data_ = nullptr;
+  size_t size_ = 0;
+};
@@ -1,9 +1,6 @@
 #pragma once
 #include "../meta/project.h"
-#include <boost/optional.hpp>
-#include <memory>
-#include <string>
-#include <vector>
+#include <cstddef>
 
 static constexpr char effect_uri[] = PROJECT_URI;
 static constexpr char effect_binary_file[] = PROJECT_NAME ".fx";
@@ -11,10 +8,29 @@ static constexpr char effect_binary_file[] = PROJECT_NAME ".fx";
 static constexpr char ui_uri[] = PROJECT_URI "#ui";
 static constexpr char ui_binary_file[] = PROJECT_NAME ".ui";
 
-struct EffectManifest;
-struct UIManifest;
-extern const EffectManifest effect_manifest;
-extern const boost::optional<UIManifest> ui_manifest;
+//==============================================================================
+// a view of a constant array, which can be built in a constant expression
+template <class T>
+class ArrayRef {
+public:
+  constexpr ArrayRef() noexcept {}
+  template <size_t N>
+  constexpr ArrayRef(const T (&array)[N]) noexcept
+      : data_(array), size_(N) {}
+
+  constexpr const T *data() const noexcept { return data_; }
+  constexpr size_t size() const noexcept { return size_; }
+  constexpr bool empty() const noexcept { return size_ == 0; }
+  constexpr const T &operator[](size_t i) const noexcept { return data_[i]; }
+  constexpr const T *begin() const noexcept { return data_; }
+  constexpr const T *end() const noexcept { return data_ + size_; }
+
+private:
+  const T *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+typedef ArrayRef<const char *> URIList;
 
 //==============================================================================
 enum class PortDirection {
@@ -34,56 +50,80 @@ enum class RequiredFeature : bool {
 };
 
 struct FeatureRequest {
-  std::string uri;
-  RequiredFeature required = RequiredFeature::Yes;
+  const char *uri;
+  RequiredFeature required;
 };
 
 struct Port {
-  PortDirection direction = PortDirection::Input;
-  std::string symbol;
-  std::string name;
-  std::string designation;
-  virtual ~Port() {}
-  virtual PortKind kind() const = 0;
-};
+  PortKind kind;
+  PortDirection direction;
+  const char *symbol;
+  const char *name;
+  const char *designation;
+  URIList properties;
+  // control ports
+  float default_value;
+  float minimum_value;
+  float maximum_value;
+  // event ports
+  const char *buffer_type;
+  URIList supports;
 
-struct AudioPort : Port {
-  PortKind kind() const override { return PortKind::Audio; }
+  constexpr Port with_designation(const char *uri) const {
+    Port p = *this; p.designation = uri; return p;
+  }
+  constexpr Port with_properties(URIList uris) const {
+    Port p = *this; p.properties = uris; return p;
+  }
 };
 
-struct ControlPort : Port {
-  float default_value {};
-  float minimum_value {};
-  float maximum_value {};
-  PortKind kind() const override { return PortKind::Control; }
-};
+constexpr Port audio_port(PortDirection direction, const char *symbol, const char *name) {
+  return Port{PortKind::Audio, direction, symbol, name, nullptr, {},
+              0, 0, 0, nullptr, {}};
+}
 
-struct EventPort : Port {
-  std::string buffer_type;
-  std::vector<std::string> supports;
-  PortKind kind() const override { return PortKind::Event; }
-};
+constexpr Port control_port(
+    PortDirection direction, const char *symbol, const char *name,
+    float default_value, float minimum_value, float maximum_value) {
+  return Port{PortKind::Control, direction, symbol, name, nullptr, {},
+              default_value, minimum_value, maximum_value, nullptr, {}};
+}
+
+constexpr Port event_port(
+    PortDirection direction, const char *symbol, const char *name,
+    const char *buffer_type, URIList supports) {
+  return Port{PortKind::Event, direction, symbol, name, nullptr, {},
+              0, 0, 0, buffer_type, supports};
+}
 
 struct PortNotification {
-  std::string symbol;
-  std::string protocol;
-  std::string notify_type;
+  const char *symbol;
+  const char *protocol;
+  const char *notify_type;
 };
 
 struct EffectManifest {
-  std::string uri;
-  std::string name;
-  std::vector<std::string> categories;
-  std::vector<FeatureRequest> features;
-  std::vector<std::string> extension_data;
-  std::vector<std::unique_ptr<Port>> ports;
+  const char *uri;
+  const char *name;
+  URIList categories;
+  ArrayRef<FeatureRequest> features;
+  URIList required_options;
+  URIList supported_options;
+  URIList extension_data;
+  ArrayRef<Port> ports;
 };
 
 struct UIManifest {
-  std::string uri;
-  std::string effect_uri;
-  std::string uiclass;
-  std::vector<FeatureRequest> features;
-  std::vector<std::string> extension_data;
-  std::vector<PortNotification> port_notifications;
+  const char *uri;
+  const char *uiclass;
+  ArrayRef<FeatureRequest> features;
+  URIList supported_options;
+  URIList extension_data;
+  ArrayRef<PortNotification> port_notifications;
 };
+
+//==============================================================================
+// the effects in the binary, the index matching the descriptor index
+extern const ArrayRef<EffectManifest> effect_manifests;
+// the UI shared by the effects, or null if there is no UI
+extern const UIManifest *const ui_manifest;
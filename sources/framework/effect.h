@@ -1,28 +1,43 @@
 #pragma once
+#include "description.h"
 #include "lv2all.h"
-#include <memory>
 #include <cstdint>
+class Worker;
+class TelemetryChannel;
 
+// Interface of the DSP, implemented by each variant of the effect
 class Effect {
  public:
-  Effect(double rate, LV2_URID_Map *map, LV2_URID_Unmap *unmap,
-         const char *bundle_path);
-  ~Effect();
+  virtual ~Effect() {}
 
   //============================================================================
-  void option(const LV2_Options_Option &o);
+  virtual void option(const LV2_Options_Option &o) = 0;
+  // called after the options are set, before the first activation
+  virtual void prepare() = 0;
 
   //============================================================================
-  void connect_port(uint32_t port, void *data);
+  virtual void connect_port(uint32_t port, void *data) = 0;
 
   //============================================================================
-  void activate();
-  void deactivate();
+  virtual void activate() = 0;
+  virtual void deactivate() = 0;
 
   //============================================================================
-  void run(unsigned nframes);
+  virtual void run(unsigned nframes) = 0;
 
- private:
-  struct Impl;
-  const std::unique_ptr<Impl> P;
+  //============================================================================
+  // non-realtime job scheduled with Worker::schedule_work
+  virtual void work(uint32_t type, const void *data, uint32_t size) = 0;
+  // response to a job sent with Worker::respond
+  virtual void work_response(uint32_t type, const void *data, uint32_t size) = 0;
+
+  //============================================================================
+  // snapshots for a UI which accesses the instance directly
+  virtual TelemetryChannel *telemetry_channel() = 0;
 };
+
+typedef Effect *(EffectFactory)(double rate, LV2_URID_Map *map, LV2_URID_Unmap *unmap,
+                                const char *bundle_path, Worker *worker);
+
+// the constructors of the effects, the index matching `effect_manifests`
+extern const ArrayRef<EffectFactory *> effect_factories;
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+// Glyphs rasterized at build time, by the tool makefontatlas
+//
+// The metrics are in pixels at the size of the face, rounded like fontstash
+// does, so the text is placed as NanoVG would place it.
+struct FontAtlasGlyph {
+  uint32_t codepoint;
+  // rectangle of the bitmap in the atlas
+  uint16_t x, y, width, height;
+  // offset of the bitmap from the pen position on the baseline
+  int16_t left, top;
+  int16_t advance;
+};
+
+struct FontAtlasKerning {
+  uint32_t first, second;
+  int16_t advance;
+};
+
+struct FontAtlasFace {
+  const char *name;
+  float size;
+  float ascender, descender, line_height;
+  // glyphs sorted by codepoint
+  const FontAtlasGlyph *glyphs;
+  unsigned glyph_count;
+  // kerning pairs sorted by first and second codepoint
+  const FontAtlasKerning *kerning;
+  unsigned kerning_count;
+};
+
+struct FontAtlasData {
+  unsigned width, height;
+  // coverage of the pixels, in rows from the top
+  const uint8_t *pixels;
+  const FontAtlasFace *faces;
+  unsigned face_count;
+};
+
+// get the atlas generated for the module, which can have no faces
+const FontAtlasData &font_atlas_data();
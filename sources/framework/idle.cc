@@ -0,0 +1,66 @@
+#include "idle.h"
+#include <chrono>
+#if defined(__unix__) && !defined(__APPLE__)
+# include <GL/glx.h>
+# include <X11/Xlib.h>
+# include <poll.h>
+# define IDLE_USE_X11 1
+#endif
+
+struct IdleScheduler::Impl {
+  typedef std::chrono::steady_clock clock;
+  clock::duration frame_period {};
+  clock::time_point last_redraw {};
+  bool redraw_requested = false;
+#if defined(IDLE_USE_X11)
+  Display *display = nullptr;
+#endif
+};
+
+IdleScheduler::IdleScheduler(double frame_rate)
+    : P(new Impl) {
+  P->frame_period = std::chrono::duration_cast<Impl::clock::duration>(
+      std::chrono::duration<double>(1 / frame_rate));
+}
+
+IdleScheduler::~IdleScheduler() {
+}
+
+void IdleScheduler::attach_current_display() {
+#if defined(IDLE_USE_X11)
+  P->display = glXGetCurrentDisplay();
+#endif
+}
+
+bool IdleScheduler::events_pending() {
+#if defined(IDLE_USE_X11)
+  Display *display = P->display;
+  if (!display)
+    return true;
+  // events already read from the connection, then data on the socket
+  if (XQLength(display) > 0)
+    return true;
+  pollfd pfd;
+  pfd.fd = ConnectionNumber(display);
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  return poll(&pfd, 1, 0) != 0;
+#else
+  return true;
+#endif
+}
+
+void IdleScheduler::request_redraw() {
+  P->redraw_requested = true;
+}
+
+bool IdleScheduler::should_redraw() {
+  if (!P->redraw_requested)
+    return false;
+  Impl::clock::time_point now = Impl::clock::now();
+  if (now - P->last_redraw < P->frame_period)
+    return false;
+  P->last_redraw = now;
+  P->redraw_requested = false;
+  return true;
+}
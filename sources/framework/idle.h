@@ -0,0 +1,30 @@
+#pragma once
+#include <memory>
+
+// Scheduler of the work of the idle callback of an OpenGL UI
+//
+// The connection to the window system is polled without blocking, so the
+// events are processed only when some are pending. The redraw requests are
+// coalesced into at most one redraw per display frame. When there is nothing
+// to do, the idle callback costs a few cheap checks.
+class IdleScheduler {
+ public:
+  explicit IdleScheduler(double frame_rate = 60);
+  ~IdleScheduler();
+
+  // watch the display connection of the current GL context
+  // until attached, the events are always assumed to be pending
+  void attach_current_display();
+
+  // whether the window system has events waiting to be processed
+  bool events_pending();
+
+  // request a redraw, coalesced with the other requests of the frame
+  void request_redraw();
+  // whether a redraw should happen now, clearing the request if so
+  bool should_redraw();
+
+ private:
+  struct Impl;
+  const std::unique_ptr<Impl> P;
+};
@@ -0,0 +1,108 @@
+#include "kernels.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(KERNELS_HAVE_SSE2)
+extern const Kernels kernels_sse2;
+#endif
+#if defined(KERNELS_HAVE_AVX2)
+extern const Kernels kernels_avx2;
+#endif
+#if defined(KERNELS_HAVE_AVX512)
+extern const Kernels kernels_avx512;
+#endif
+
+//==============================================================================
+static void scalar_fill(float *dst, float value, unsigned n) {
+  std::fill_n(dst, n, value);
+}
+
+static void scalar_copy(float *dst, const float *src, unsigned n) {
+  std::copy_n(src, n, dst);
+}
+
+static void scalar_mix(float *dst, const float *src, float gain, unsigned n) {
+  for (unsigned i = 0; i < n; ++i)
+    dst[i] += gain * src[i];
+}
+
+static void scalar_gain_ramp(float *dst, const float *src, float g1, float g2, unsigned n) {
+  float step = (n > 0) ? ((g2 - g1) / n) : 0;
+  for (unsigned i = 0; i < n; ++i)
+    dst[i] = src[i] * (g1 + i * step);
+}
+
+static void scalar_interleave(float *dst, const float *left, const float *right, unsigned n) {
+  for (unsigned i = 0; i < n; ++i) {
+    dst[2 * i] = left[i];
+    dst[2 * i + 1] = right[i];
+  }
+}
+
+static void scalar_deinterleave(float *left, float *right, const float *src, unsigned n) {
+  for (unsigned i = 0; i < n; ++i) {
+    left[i] = src[2 * i];
+    right[i] = src[2 * i + 1];
+  }
+}
+
+static float scalar_peak(const float *src, unsigned n) {
+  float peak = 0;
+  for (unsigned i = 0; i < n; ++i)
+    peak = std::max(peak, std::fabs(src[i]));
+  return peak;
+}
+
+static float scalar_rms(const float *src, unsigned n) {
+  float sum = 0;
+  for (unsigned i = 0; i < n; ++i)
+    sum += src[i] * src[i];
+  return (n > 0) ? std::sqrt(sum / n) : 0;
+}
+
+static void scalar_clamp(float *dst, const float *src, float lo, float hi, unsigned n) {
+  for (unsigned i = 0; i < n; ++i)
+    dst[i] = std::min(std::max(src[i], lo), hi);
+}
+
+static const Kernels kernels_scalar = {
+  "scalar",
+  &scalar_fill,
+  &scalar_copy,
+  &scalar_mix,
+  &scalar_gain_ramp,
+  &scalar_interleave,
+  &scalar_deinterleave,
+  &scalar_peak,
+  &scalar_rms,
+  &scalar_clamp,
+};
+
+//==============================================================================
+static const Kernels &select_kernels() {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  __builtin_cpu_init();
+# if defined(KERNELS_HAVE_AVX512)
+  if (__builtin_cpu_supports("avx512f"))
+    return kernels_avx512;
+# endif
+# if defined(KERNELS_HAVE_AVX2)
+  if (__builtin_cpu_supports("avx2"))
+    return kernels_avx2;
+# endif
+# if defined(KERNELS_HAVE_SSE2)
+  if (__builtin_cpu_supports("sse2"))
+    return kernels_sse2;
+# endif
+#endif
+  return kernels_scalar;
+}
+
+const Kernels &kernels() {
+  static const Kernels &k = select_kernels();
+  return k;
+}
+
+const Kernels &scalar_kernels() {
+  return kernels_scalar;
+}
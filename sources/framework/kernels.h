@@ -0,0 +1,34 @@
+#pragma once
+
+// Table of buffer processing kernels
+//
+// Different implementations exist for the instruction sets which the
+// processor supports. The best one is selected at run time.
+struct Kernels {
+  const char *name;
+
+  // dst[i] = value
+  void (*fill)(float *dst, float value, unsigned n);
+  // dst[i] = src[i]
+  void (*copy)(float *dst, const float *src, unsigned n);
+  // dst[i] += gain * src[i]
+  void (*mix)(float *dst, const float *src, float gain, unsigned n);
+  // dst[i] = src[i] * gain, gain linearly ramped from `g1` to `g2`
+  void (*gain_ramp)(float *dst, const float *src, float g1, float g2, unsigned n);
+  // dst[2*i] = left[i], dst[2*i+1] = right[i]
+  void (*interleave)(float *dst, const float *left, const float *right, unsigned n);
+  // left[i] = src[2*i], right[i] = src[2*i+1]
+  void (*deinterleave)(float *left, float *right, const float *src, unsigned n);
+  // max |src[i]|
+  float (*peak)(const float *src, unsigned n);
+  // sqrt(sum src[i]^2 / n)
+  float (*rms)(const float *src, unsigned n);
+  // dst[i] = min(max(src[i], lo), hi)
+  void (*clamp)(float *dst, const float *src, float lo, float hi, unsigned n);
+};
+
+// get the best kernels for this processor, selected on the first call
+const Kernels &kernels();
+
+// get the portable kernels
+const Kernels &scalar_kernels();
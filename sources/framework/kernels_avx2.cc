@@ -0,0 +1,53 @@
+#include "kernels_simd.h"
+#include <immintrin.h>
+
+namespace {
+
+struct Avx2 {
+  typedef __m256 type;
+  static constexpr unsigned size = 8;
+
+  static type load(const float *p) { return _mm256_loadu_ps(p); }
+  static void store(float *p, type x) { _mm256_storeu_ps(p, x); }
+  static type set1(float x) { return _mm256_set1_ps(x); }
+  static type ramp() { return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7); }
+  static type add(type a, type b) { return _mm256_add_ps(a, b); }
+  static type mul(type a, type b) { return _mm256_mul_ps(a, b); }
+  static type min(type a, type b) { return _mm256_min_ps(a, b); }
+  static type max(type a, type b) { return _mm256_max_ps(a, b); }
+  static type abs(type x) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x); }
+
+  static float hsum(type x) {
+    __m128 y = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+    y = _mm_add_ps(y, _mm_movehl_ps(y, y));
+    y = _mm_add_ss(y, _mm_shuffle_ps(y, y, 1));
+    return _mm_cvtss_f32(y);
+  }
+
+  static float hmax(type x) {
+    __m128 y = _mm_max_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+    y = _mm_max_ps(y, _mm_movehl_ps(y, y));
+    y = _mm_max_ss(y, _mm_shuffle_ps(y, y, 1));
+    return _mm_cvtss_f32(y);
+  }
+
+  static void interleave(type a, type b, type &lo, type &hi) {
+    type l = _mm256_unpacklo_ps(a, b);
+    type h = _mm256_unpackhi_ps(a, b);
+    lo = _mm256_permute2f128_ps(l, h, 0x20);
+    hi = _mm256_permute2f128_ps(l, h, 0x31);
+  }
+
+  static void deinterleave(type lo, type hi, type &a, type &b) {
+    const __m256i order = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+    type e = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    type o = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+    a = _mm256_permutevar8x32_ps(e, order);
+    b = _mm256_permutevar8x32_ps(o, order);
+  }
+};
+
+} // namespace
+
+extern const Kernels kernels_avx2;
+const Kernels kernels_avx2 = SimdKernels<Avx2>::table("avx2");
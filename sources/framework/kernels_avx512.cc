@@ -0,0 +1,55 @@
+#include "kernels_simd.h"
+
+// the AVX-512 intrinsics of GCC pass `_mm512_undefined_ps()` and the like as
+// the masked-off source operand, which GCC reports as uninitialized once the
+// intrinsics are inlined; the warnings are located in the system header, so
+// the suppression must cover the include as well as the uses
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#include <immintrin.h>
+
+namespace {
+
+struct Avx512 {
+  typedef __m512 type;
+  static constexpr unsigned size = 16;
+
+  static type load(const float *p) { return _mm512_loadu_ps(p); }
+  static void store(float *p, type x) { _mm512_storeu_ps(p, x); }
+  static type set1(float x) { return _mm512_set1_ps(x); }
+  static type ramp() { return _mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15); }
+  static type add(type a, type b) { return _mm512_add_ps(a, b); }
+  static type mul(type a, type b) { return _mm512_mul_ps(a, b); }
+  static type min(type a, type b) { return _mm512_min_ps(a, b); }
+  static type max(type a, type b) { return _mm512_max_ps(a, b); }
+  static type abs(type x) { return _mm512_abs_ps(x); }
+  static float hsum(type x) { return _mm512_reduce_add_ps(x); }
+  static float hmax(type x) { return _mm512_reduce_max_ps(x); }
+
+  static void interleave(type a, type b, type &lo, type &hi) {
+    const __m512i ilo = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+    const __m512i ihi = _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+    lo = _mm512_permutex2var_ps(a, ilo, b);
+    hi = _mm512_permutex2var_ps(a, ihi, b);
+  }
+
+  static void deinterleave(type lo, type hi, type &a, type &b) {
+    const __m512i ie = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i io = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    a = _mm512_permutex2var_ps(lo, ie, hi);
+    b = _mm512_permutex2var_ps(lo, io, hi);
+  }
+};
+
+} // namespace
+
+extern const Kernels kernels_avx512;
+const Kernels kernels_avx512 = SimdKernels<Avx512>::table("avx512");
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
@@ -0,0 +1,140 @@
+#pragma once
+#include "kernels.h"
+#include <math.h>
+
+// Generic implementation of the kernels over a vector type `V`
+//
+// This header is included by the translation units of each instruction set,
+// which are compiled with their respective code generation flags. It must not
+// define any entity with external linkage, since the linker could merge the
+// definitions of different instruction sets. For the same reason, the scalar
+// parts avoid the inline functions of the standard library.
+
+namespace {
+
+template <class V>
+struct SimdKernels {
+  typedef typename V::type vec;
+  static constexpr unsigned N = V::size;
+
+  static void fill(float *dst, float value, unsigned n) {
+    unsigned i = 0;
+    vec x = V::set1(value);
+    for (; i + N <= n; i += N)
+      V::store(dst + i, x);
+    for (; i < n; ++i)
+      dst[i] = value;
+  }
+
+  static void copy(float *dst, const float *src, unsigned n) {
+    unsigned i = 0;
+    for (; i + N <= n; i += N)
+      V::store(dst + i, V::load(src + i));
+    for (; i < n; ++i)
+      dst[i] = src[i];
+  }
+
+  static void mix(float *dst, const float *src, float gain, unsigned n) {
+    unsigned i = 0;
+    vec g = V::set1(gain);
+    for (; i + N <= n; i += N)
+      V::store(dst + i, V::add(V::load(dst + i), V::mul(g, V::load(src + i))));
+    for (; i < n; ++i)
+      dst[i] += gain * src[i];
+  }
+
+  static void gain_ramp(float *dst, const float *src, float g1, float g2, unsigned n) {
+    float step = (n > 0) ? ((g2 - g1) / n) : 0;
+    unsigned i = 0;
+    vec g = V::add(V::set1(g1), V::mul(V::ramp(), V::set1(step)));
+    vec dg = V::set1(N * step);
+    for (; i + N <= n; i += N) {
+      V::store(dst + i, V::mul(V::load(src + i), g));
+      g = V::add(g, dg);
+    }
+    for (; i < n; ++i)
+      dst[i] = src[i] * (g1 + i * step);
+  }
+
+  static void interleave(float *dst, const float *left, const float *right, unsigned n) {
+    unsigned i = 0;
+    for (; i + N <= n; i += N) {
+      vec lo, hi;
+      V::interleave(V::load(left + i), V::load(right + i), lo, hi);
+      V::store(dst + 2 * i, lo);
+      V::store(dst + 2 * i + N, hi);
+    }
+    for (; i < n; ++i) {
+      dst[2 * i] = left[i];
+      dst[2 * i + 1] = right[i];
+    }
+  }
+
+  static void deinterleave(float *left, float *right, const float *src, unsigned n) {
+    unsigned i = 0;
+    for (; i + N <= n; i += N) {
+      vec l, r;
+      V::deinterleave(V::load(src + 2 * i), V::load(src + 2 * i + N), l, r);
+      V::store(left + i, l);
+      V::store(right + i, r);
+    }
+    for (; i < n; ++i) {
+      left[i] = src[2 * i];
+      right[i] = src[2 * i + 1];
+    }
+  }
+
+  static float peak(const float *src, unsigned n) {
+    unsigned i = 0;
+    vec m = V::set1(0);
+    for (; i + N <= n; i += N)
+      m = V::max(m, V::abs(V::load(src + i)));
+    float peak = V::hmax(m);
+    for (; i < n; ++i) {
+      float x = (src[i] < 0) ? -src[i] : src[i];
+      peak = (x > peak) ? x : peak;
+    }
+    return peak;
+  }
+
+  static float rms(const float *src, unsigned n) {
+    unsigned i = 0;
+    vec s = V::set1(0);
+    for (; i + N <= n; i += N) {
+      vec x = V::load(src + i);
+      s = V::add(s, V::mul(x, x));
+    }
+    float sum = V::hsum(s);
+    for (; i < n; ++i)
+      sum += src[i] * src[i];
+    return (n > 0) ? sqrtf(sum / n) : 0;
+  }
+
+  static void clamp(float *dst, const float *src, float lo, float hi, unsigned n) {
+    unsigned i = 0;
+    vec vlo = V::set1(lo), vhi = V::set1(hi);
+    for (; i + N <= n; i += N)
+      V::store(dst + i, V::min(V::max(V::load(src + i), vlo), vhi));
+    for (; i < n; ++i) {
+      float x = (src[i] > lo) ? src[i] : lo;
+      dst[i] = (x < hi) ? x : hi;
+    }
+  }
+
+  static constexpr Kernels table(const char *name) {
+    return Kernels{
+      name,
+      &fill,
+      &copy,
+      &mix,
+      &gain_ramp,
+      &interleave,
+      &deinterleave,
+      &peak,
+      &rms,
+      &clamp,
+    };
+  }
+};
+
+} // namespace
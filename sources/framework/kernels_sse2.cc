@@ -0,0 +1,46 @@
+#include "kernels_simd.h"
+#include <immintrin.h>
+
+namespace {
+
+struct Sse2 {
+  typedef __m128 type;
+  static constexpr unsigned size = 4;
+
+  static type load(const float *p) { return _mm_loadu_ps(p); }
+  static void store(float *p, type x) { _mm_storeu_ps(p, x); }
+  static type set1(float x) { return _mm_set1_ps(x); }
+  static type ramp() { return _mm_setr_ps(0, 1, 2, 3); }
+  static type add(type a, type b) { return _mm_add_ps(a, b); }
+  static type mul(type a, type b) { return _mm_mul_ps(a, b); }
+  static type min(type a, type b) { return _mm_min_ps(a, b); }
+  static type max(type a, type b) { return _mm_max_ps(a, b); }
+  static type abs(type x) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), x); }
+
+  static float hsum(type x) {
+    x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+    x = _mm_add_ss(x, _mm_shuffle_ps(x, x, 1));
+    return _mm_cvtss_f32(x);
+  }
+
+  static float hmax(type x) {
+    x = _mm_max_ps(x, _mm_movehl_ps(x, x));
+    x = _mm_max_ss(x, _mm_shuffle_ps(x, x, 1));
+    return _mm_cvtss_f32(x);
+  }
+
+  static void interleave(type a, type b, type &lo, type &hi) {
+    lo = _mm_unpacklo_ps(a, b);
+    hi = _mm_unpackhi_ps(a, b);
+  }
+
+  static void deinterleave(type lo, type hi, type &a, type &b) {
+    a = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    b = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+  }
+};
+
+} // namespace
+
+extern const Kernels kernels_sse2;
+const Kernels kernels_sse2 = SimdKernels<Sse2>::table("sse2");
@@ -0,0 +1,71 @@
+#include "loadmeter.h"
+#include <algorithm>
+#include <cmath>
+
+LoadMeter::LoadMeter(double rate)
+    : rate_(rate) {
+  reset();
+}
+
+void LoadMeter::reset() {
+  current_.store(0);
+  peak_.store(0);
+  count_.store(0);
+  for (std::atomic<uint32_t> &bin : bins_)
+    bin.store(0);
+}
+
+void LoadMeter::begin() {
+  start_ = clock::now();
+}
+
+void LoadMeter::end(unsigned nframes) {
+  if (nframes == 0)
+    return;
+
+  clock::duration elapsed = clock::now() - start_;
+  float load = std::chrono::duration<double>(elapsed).count() * rate_ / nframes;
+
+  current_.store(load, std::memory_order_relaxed);
+  if (load > peak_.load(std::memory_order_relaxed))
+    peak_.store(load, std::memory_order_relaxed);
+
+  bins_[bin_of(load)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_release);
+}
+
+float LoadMeter::current() const {
+  return current_.load(std::memory_order_relaxed);
+}
+
+float LoadMeter::peak() const {
+  return peak_.load(std::memory_order_relaxed);
+}
+
+float LoadMeter::percentile(float p) const {
+  uint32_t count = count_.load(std::memory_order_acquire);
+  if (count == 0)
+    return 0;
+
+  // the upper bound of the bin which contains the percentile
+  uint32_t threshold = std::max(1u, uint32_t(std::ceil(p * count)));
+  uint32_t sum = 0;
+  for (unsigned i = 0; i < num_bins; ++i) {
+    sum += bins_[i].load(std::memory_order_relaxed);
+    if (sum >= threshold)
+      return load_of(i + 1);
+  }
+  return load_of(num_bins);
+}
+
+unsigned LoadMeter::bin_of(float load) {
+  if (!(load > 0))
+    return 0;
+  float octave = std::log2(load);
+  int bin = int(std::floor((octave - min_octave) * bins_per_octave));
+  return unsigned(std::max(0, std::min(int(num_bins) - 1, bin)));
+}
+
+float LoadMeter::load_of(unsigned bin) {
+  return std::exp2(min_octave + float(bin) / bins_per_octave);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Measurement of the processing time of blocks, relative to their duration
+//
+// Each block is timed with a monotonic clock, and its load is accumulated in a
+// histogram with a logarithmic scale. The statistics can be read while the
+// measurement goes on, from any thread.
+class LoadMeter {
+ public:
+  explicit LoadMeter(double rate);
+
+  // [non-realtime] clear the statistics
+  void reset();
+
+  // [realtime] delimit the processing of a block
+  void begin();
+  void end(unsigned nframes);
+
+  // loads, as ratios of processing time to real time
+  float current() const;
+  float peak() const;
+  float percentile(float p) const;
+
+ private:
+  static unsigned bin_of(float load);
+  static float load_of(unsigned bin);
+
+ private:
+  typedef std::chrono::steady_clock clock;
+  static constexpr unsigned bins_per_octave = 8;
+  static constexpr int min_octave = -14;
+  static constexpr int max_octave = 4;
+  static constexpr unsigned num_bins = (max_octave - min_octave) * bins_per_octave;
+
+  double rate_ = 0;
+  clock::time_point start_;
+  std::atomic<float> current_ {0};
+  std::atomic<float> peak_ {0};
+  std::atomic<uint32_t> count_ {0};
+  std::atomic<uint32_t> bins_[num_bins];
+};
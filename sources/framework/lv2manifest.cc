@@ -1,21 +1,19 @@
 #include "description.h"
+#include "turtle.h"
 #include "lv2all.h"
-#include <boost/locale/encoding_utf.hpp>
 #include <boost/utility/string_view.hpp>
-#include <iterator>
+#include <unordered_map>
+#include <memory>
 #include <string>
 #include <fstream>
-#include <sstream>
+#include <iostream>
 #include <cassert>
 
 //==============================================================================
-static void write_prefix(std::ostream &ttl);
-static void write_effect_manifest(const EffectManifest &m, std::ostream &ttl);
-static void write_ui_manifest(const UIManifest &m, std::ostream &ttl);
-
-//==============================================================================
-static std::string ttl_uri(boost::string_view uri);
-static std::string ttl_string(boost::string_view uri);
+static void write_prefix(TurtleWriter &ttl);
+static void write_effect_manifest(const EffectManifest &m, TurtleWriter &ttl);
+static void write_ui_manifest(const UIManifest &m, TurtleWriter &ttl);
+static bool write_file(const std::string &path, const std::string &data);
 
 //==============================================================================
 static std::string catN(const boost::string_view *a, unsigned n);
@@ -25,15 +23,19 @@ static std::string cat3(boost::string_view a, boost::string_view b, boost::strin
 //==============================================================================
 LV2_SYMBOL_EXPORT
 bool lv2_write_manifest(const char *directory, bool single_file) {
-  const EffectManifest &fxm = ::effect_manifest;
-  const boost::optional<UIManifest> &opt_uim = ::ui_manifest;
+  const ArrayRef<EffectManifest> &fxms = ::effect_manifests;
+  const UIManifest *opt_uim = ::ui_manifest;
+
+  std::string buffer;
 
   //============================================================================
-  std::ofstream ttl(cat2(directory, "/manifest.ttl"), std::ios::binary);
+  std::string manifest;
+  TurtleWriter ttl(manifest);
   write_prefix(ttl);
 
   if (single_file) {
-    write_effect_manifest(fxm, ttl);
+    for (const EffectManifest &fxm : fxms)
+      write_effect_manifest(fxm, ttl);
     if (opt_uim) {
       const UIManifest &uim = *opt_uim;
       write_ui_manifest(uim, ttl);
@@ -42,76 +44,107 @@ bool lv2_write_manifest(const char *directory, bool single_file) {
     std::string effect_ttl_file = cat2(effect_binary_file, ".ttl");
     std::string ui_ttl_file = cat2(ui_binary_file, ".ttl");
 
-    ttl << ttl_uri(fxm.uri) << "\n";
-    ttl << "  a lv2:Plugin ;\n";
-    ttl << "  lv2:binary " << ttl_uri(effect_binary_file) << " ;\n";
-    ttl << "  rdfs:seeAlso " << ttl_uri(effect_ttl_file) << " .\n";
-
-    std::ofstream fxttl(cat3(directory, "/", effect_ttl_file), std::ios::binary);
+    buffer.clear();
+    TurtleWriter fxttl(buffer);
     write_prefix(fxttl);
-    write_effect_manifest(fxm, fxttl);
-    if (!fxttl.flush())
+
+    for (const EffectManifest &fxm : fxms) {
+      ttl.subject(fxm.uri);
+      ttl.predicate("a");
+      ttl.object_name("lv2:Plugin");
+      ttl.predicate("lv2:binary");
+      ttl.object_uri(effect_binary_file);
+      ttl.predicate("rdfs:seeAlso");
+      ttl.object_uri(effect_ttl_file);
+      ttl.end_subject();
+
+      write_effect_manifest(fxm, fxttl);
+    }
+    if (!write_file(cat3(directory, "/", effect_ttl_file), buffer))
       return false;
 
     if (opt_uim) {
       const UIManifest &uim = *opt_uim;
-      ttl << ttl_uri(uim.uri) << "\n";
-      ttl << "  a " << ttl_uri(uim.uiclass) << " ;\n";
-      ttl << "  lv2:binary " << ttl_uri(ui_binary_file) << " ;\n";
-      ttl << "  rdfs:seeAlso " << ttl_uri(ui_ttl_file) << " .\n";
-
-      std::ofstream uittl(cat3(directory, "/", ui_ttl_file), std::ios::binary);
+      ttl.subject(uim.uri);
+      ttl.predicate("a");
+      ttl.object_uri(uim.uiclass);
+      ttl.predicate("lv2:binary");
+      ttl.object_uri(ui_binary_file);
+      ttl.predicate("rdfs:seeAlso");
+      ttl.object_uri(ui_ttl_file);
+      ttl.end_subject();
+
+      buffer.clear();
+      TurtleWriter uittl(buffer);
       write_prefix(uittl);
       write_ui_manifest(uim, uittl);
-      if (!uittl.flush())
+      if (!write_file(cat3(directory, "/", ui_ttl_file), buffer))
         return false;
     }
   }
 
   //============================================================================
-  if (!ttl.flush())
-    return false;
-
-  return true;
+  return write_file(cat2(directory, "/manifest.ttl"), manifest);
 }
 
-//============================================================================
-std::string lv2_manifest_string_subjects() {
-  const EffectManifest &fxm = ::effect_manifest;
-
-  std::ostringstream ttl(std::ios::binary);
-  write_prefix(ttl);
-
-  ttl << ttl_uri(fxm.uri) << " a lv2:Plugin .\n";
-  return ttl.str();
+//==============================================================================
+// description of the effects, for use by the tools
+LV2_SYMBOL_EXPORT
+const EffectManifest *lv2_effect_manifest(uint32_t index) {
+  const ArrayRef<EffectManifest> &fxms = ::effect_manifests;
+  if (index >= fxms.size())
+    return nullptr;
+  return &fxms[index];
 }
 
-std::string lv2_manifest_string_data() {
-  const EffectManifest &fxm = ::effect_manifest;
-  const boost::optional<UIManifest> &opt_uim = ::ui_manifest;
-
-  std::ostringstream ttl(std::ios::binary);
+//==============================================================================
+// dynamic manifest, serialized once when opened
+struct DynManifest {
+  std::string subjects;
+  std::unordered_map<std::string, std::string> data;
+  void add(const EffectManifest &fxm, const UIManifest *opt_uim);
+};
+
+void DynManifest::add(const EffectManifest &fxm, const UIManifest *opt_uim) {
+  TurtleWriter subj(subjects);
+  subj.subject(fxm.uri);
+  subj.predicate("a");
+  subj.object_name("lv2:Plugin");
+  subj.end_subject();
+
+  std::string &entry = data[fxm.uri];
+  TurtleWriter ttl(entry);
   write_prefix(ttl);
-
   write_effect_manifest(fxm, ttl);
   if (opt_uim) {
     const UIManifest &uim = *opt_uim;
     write_ui_manifest(uim, ttl);
   }
-  return ttl.str();
 }
 
 //==============================================================================
 LV2_SYMBOL_EXPORT
 int lv2_dyn_manifest_open(
     LV2_Dyn_Manifest_Handle *handle, const LV2_Feature *const *features) {
+  try {
+    std::unique_ptr<DynManifest> dm(new DynManifest);
+    TurtleWriter subj(dm->subjects);
+    write_prefix(subj);
+    for (const EffectManifest &fxm : ::effect_manifests)
+      dm->add(fxm, ::ui_manifest);
+    *handle = dm.release();
+  } catch (std::exception &ex) {
+    std::cerr << "error opening the dynamic manifest: " << ex.what() << "\n";
+    return 1;
+  }
   return 0;
 }
 
 LV2_SYMBOL_EXPORT
 int lv2_dyn_manifest_get_subjects(
     LV2_Dyn_Manifest_Handle handle, FILE *fp) {
-  std::string subj = lv2_manifest_string_subjects();
+  const DynManifest &dm = *reinterpret_cast<DynManifest *>(handle);
+  const std::string &subj = dm.subjects;
 
   if (fwrite(subj.data(), subj.size(), 1, fp) != 1)
     return 1;
@@ -120,16 +153,14 @@ int lv2_dyn_manifest_get_subjects(
 
 LV2_SYMBOL_EXPORT
 int lv2_dyn_manifest_get_data(
-    LV2_Dyn_Manifest_Handle handle, FILE *fp, const char *uri_) {
-  const EffectManifest &fxm = ::effect_manifest;
+    LV2_Dyn_Manifest_Handle handle, FILE *fp, const char *uri) {
+  const DynManifest &dm = *reinterpret_cast<DynManifest *>(handle);
 
-  boost::string_view uri(uri_);
-
-  std::string data;
-  if (uri == fxm.uri) {
-    data = lv2_manifest_string_data();
-  }
+  auto it = dm.data.find(uri);
+  if (it == dm.data.end())
+    return 1;
 
+  const std::string &data = it->second;
   if (fwrite(data.data(), data.size(), 1, fp) != 1)
     return 1;
   return 0;
@@ -137,112 +168,150 @@ int lv2_dyn_manifest_get_data(
 
 LV2_SYMBOL_EXPORT
 void lv2_dyn_manifest_close(LV2_Dyn_Manifest_Handle handle) {
+  delete reinterpret_cast<DynManifest *>(handle);
 }
 
 //==============================================================================
-static void write_prefix(std::ostream &ttl) {
-  ttl <<
-      "@prefix doap:  <http://usefulinc.com/ns/doap#> .\n"
-      "@prefix rdfs: <http://www.w3.org/2000/01/rdf-schema#> .\n"
-      "@prefix lv2:  <" LV2_CORE_PREFIX "> .\n"
-      "@prefix atom: <" LV2_ATOM_PREFIX "> .\n"
-      "@prefix ui:   <" LV2_UI_PREFIX "> .\n";
+static void write_prefix(TurtleWriter &ttl) {
+  ttl.prefix("doap", "http://usefulinc.com/ns/doap#");
+  ttl.prefix("rdfs", "http://www.w3.org/2000/01/rdf-schema#");
+  ttl.prefix("lv2", LV2_CORE_PREFIX);
+  ttl.prefix("atom", LV2_ATOM_PREFIX);
+  ttl.prefix("opts", LV2_OPTIONS_PREFIX);
+  ttl.prefix("ui", LV2_UI_PREFIX);
 }
 
-static void write_effect_manifest(const EffectManifest &m, std::ostream &ttl) {
-  ttl << "\n" << ttl_uri(m.uri);
-  ttl << "\n  a lv2:Plugin";
-  for (const std::string &cat : m.categories) ttl << ", " << ttl_uri(cat);
-  ttl << " ;";
-  ttl << "\n  lv2:binary " << ttl_uri(effect_binary_file) << " ;";
-  ttl << "\n  doap:name " << ttl_string(m.name) << " ;";
-  for (const FeatureRequest &f : m.features)
-    ttl << "\n  lv2:" << (bool(f.required) ? "required" : "optional")
-        << "Feature " << ttl_uri(f.uri) << " ;";
-  for (const std::string &e : m.extension_data)
-    ttl << "\n  lv2:extensionData " << ttl_uri(e) << " ;";
-
-  ttl << "\n  ui:ui " << ttl_uri(ui_uri) << " ;";
+static void write_features(const ArrayRef<FeatureRequest> &features, TurtleWriter &ttl) {
+  for (const FeatureRequest &f : features) {
+    ttl.predicate(bool(f.required) ? "lv2:requiredFeature" : "lv2:optionalFeature");
+    ttl.object_uri(f.uri);
+  }
+}
+
+static void write_uris(const char *predicate, const URIList &uris, TurtleWriter &ttl) {
+  if (uris.empty())
+    return;
+  ttl.predicate(predicate);
+  for (const char *uri : uris)
+    ttl.object_uri(uri);
+}
+
+static void write_effect_manifest(const EffectManifest &m, TurtleWriter &ttl) {
+  ttl.subject(m.uri);
+  ttl.predicate("a");
+  ttl.object_name("lv2:Plugin");
+  for (const char *cat : m.categories)
+    ttl.object_uri(cat);
+  ttl.predicate("lv2:binary");
+  ttl.object_uri(effect_binary_file);
+  ttl.predicate("doap:name");
+  ttl.object_string(m.name);
+  write_features(m.features, ttl);
+  write_uris("opts:requiredOption", m.required_options, ttl);
+  write_uris("opts:supportedOption", m.supported_options, ttl);
+  write_uris("lv2:extensionData", m.extension_data, ttl);
+
+  if (::ui_manifest) {
+    ttl.predicate("ui:ui");
+    ttl.object_uri(::ui_manifest->uri);
+  }
 
   for (size_t i = 0, n = m.ports.size(); i < n; ++i) {
-    ttl << "\n  lv2:port [";
+    const Port &port = m.ports[i];
+    const PortKind kind = port.kind;
 
-    const Port &port = *m.ports[i];
-    const PortKind kind = port.kind();
+    ttl.predicate("lv2:port");
+    ttl.begin_blank();
 
-    ttl << "\n    a lv2:";
+    ttl.predicate("a");
     switch (port.direction) {
-      case PortDirection::Input: ttl << "InputPort"; break;
-      case PortDirection::Output: ttl << "OutputPort"; break;
+      case PortDirection::Input: ttl.object_name("lv2:InputPort"); break;
+      case PortDirection::Output: ttl.object_name("lv2:OutputPort"); break;
       default: assert(false);
     }
     switch (kind) {
-      case PortKind::Audio: ttl << ", lv2:AudioPort"; break;
-      case PortKind::Control: ttl << ", lv2:ControlPort"; break;
-      case PortKind::Event: ttl << ", atom:AtomPort" ; break;
+      case PortKind::Audio: ttl.object_name("lv2:AudioPort"); break;
+      case PortKind::Control: ttl.object_name("lv2:ControlPort"); break;
+      case PortKind::Event: ttl.object_name("atom:AtomPort"); break;
       default: assert(false);
     }
-    ttl << " ;";
 
-    ttl << "\n    lv2:index " << i << " ;";
-    ttl << "\n    lv2:symbol " << ttl_string(port.symbol) << " ;";
-    ttl << "\n    lv2:name " << ttl_string(port.name) << " ;";
-    if (!port.designation.empty())
-      ttl << "\n    lv2:designation " << ttl_uri(port.designation) << " ;";
+    ttl.predicate("lv2:index");
+    ttl.object_integer(i);
+    ttl.predicate("lv2:symbol");
+    ttl.object_string(port.symbol);
+    ttl.predicate("lv2:name");
+    ttl.object_string(port.name);
+    if (port.designation) {
+      ttl.predicate("lv2:designation");
+      ttl.object_uri(port.designation);
+    }
+    write_uris("lv2:portProperty", port.properties, ttl);
 
     switch (kind) {
-      case PortKind::Control: {
-        const ControlPort &cp = static_cast<const ControlPort &>(port);
-        ttl << "\n    lv2:default " << cp.default_value << " ;";
-        ttl << "\n    lv2:minimum " << cp.minimum_value << " ;";
-        ttl << "\n    lv2:maximum " << cp.maximum_value << " ;";
+      case PortKind::Control:
+        ttl.predicate("lv2:default");
+        ttl.object_number(port.default_value);
+        ttl.predicate("lv2:minimum");
+        ttl.object_number(port.minimum_value);
+        ttl.predicate("lv2:maximum");
+        ttl.object_number(port.maximum_value);
         break;
-      }
-      case PortKind::Event: {
-        const EventPort &ep = static_cast<const EventPort &>(port);
-        if (!ep.buffer_type.empty())
-          ttl << "\n    atom:bufferType " << ttl_uri(ep.buffer_type) << " ;";
-        if (!ep.supports.empty()) {
-          ttl << "\n    atom:supports " << ttl_uri(ep.supports[0]);
-          for (unsigned i = 1, n = ep.supports.size(); i < n; ++i)
-            ttl << ", " << ttl_uri(ep.supports[i]);
-          ttl << " ;";
+      case PortKind::Event:
+        if (port.buffer_type) {
+          ttl.predicate("atom:bufferType");
+          ttl.object_uri(port.buffer_type);
         }
+        write_uris("atom:supports", port.supports, ttl);
         break;
-      }
       default:
         break;
     }
-    ttl << "\n  ] ;";
+
+    ttl.end_blank();
   }
 
-  ttl.seekp(-1, std::ios::cur);
-  ttl << ".\n";
+  ttl.end_subject();
 }
 
-static void write_ui_manifest(const UIManifest &m, std::ostream &ttl) {
-  ttl << "\n" << ttl_uri(m.uri);
-  ttl << "\n  a " << ttl_uri(m.uiclass) << " ;";
-  ttl << "\n  lv2:binary " << ttl_uri(ui_binary_file) << " ;";
-
-  for (const FeatureRequest &f : m.features)
-    ttl << "\n  lv2:" << (bool(f.required) ? "required" : "optional")
-        << "Feature " << ttl_uri(f.uri) << " ;";
-  for (const std::string &e : m.extension_data)
-    ttl << "\n  lv2:extensionData " << ttl_uri(e) << " ;";
-  for (const PortNotification &pn : m.port_notifications) {
-    ttl << "\n  ui:portNotification ["
-        << "\n    ui:plugin " << ttl_uri(m.effect_uri) << " ;"
-        << "\n    lv2:symbol " << ttl_string(pn.symbol) << " ;";
-    if (!pn.protocol.empty())
-      ttl << "\n    ui:protocol " << ttl_uri(pn.protocol) << " ;";
-    if (!pn.notify_type.empty())
-      ttl << "\n    ui:notifyType " << ttl_uri(pn.notify_type) << " ;";
-    ttl << "\n  ] ;";
+static void write_ui_manifest(const UIManifest &m, TurtleWriter &ttl) {
+  ttl.subject(m.uri);
+  ttl.predicate("a");
+  ttl.object_uri(m.uiclass);
+  ttl.predicate("lv2:binary");
+  ttl.object_uri(ui_binary_file);
+  write_features(m.features, ttl);
+  write_uris("opts:supportedOption", m.supported_options, ttl);
+  write_uris("lv2:extensionData", m.extension_data, ttl);
+
+  // the UI is shared by all the effects of the binary
+  for (const EffectManifest &fxm : effect_manifests) {
+    for (const PortNotification &pn : m.port_notifications) {
+      ttl.predicate("ui:portNotification");
+      ttl.begin_blank();
+      ttl.predicate("ui:plugin");
+      ttl.object_uri(fxm.uri);
+      ttl.predicate("lv2:symbol");
+      ttl.object_string(pn.symbol);
+      if (pn.protocol) {
+        ttl.predicate("ui:protocol");
+        ttl.object_uri(pn.protocol);
+      }
+      if (pn.notify_type) {
+        ttl.predicate("ui:notifyType");
+        ttl.object_uri(pn.notify_type);
+      }
+      ttl.end_blank();
+    }
   }
 
-  ttl.seekp(-1, std::ios::cur);
-  ttl << ".\n";
+  ttl.end_subject();
+}
+
+static bool write_file(const std::string &path, const std::string &data) {
+  std::ofstream stream(path, std::ios::binary);
+  stream.write(data.data(), data.size());
+  return bool(stream.flush());
 }
 
 //==============================================================================
@@ -266,58 +335,3 @@ static std::string cat3(boost::string_view a, boost::string_view b, boost::strin
   boost::string_view s[] {a, b, c};
   return catN(s, 3);
 }
-
-//==============================================================================
-static std::string ttl_uri(boost::string_view uri) {
-  using boost::locale::conv::utf_to_utf;
-  using boost::locale::utf::utf_traits;
-
-  std::string out;
-  out.reserve(2 + 2 * uri.size());
-
-  std::back_insert_iterator<std::string> it(out);
-  auto add = [&](char32_t c) { utf_traits<char>::encode(c, it); };
-
-  const std::u32string unicode = utf_to_utf<char32_t>(
-      uri.data(), uri.data() + uri.size());
-  add('<');
-  for (const char32_t c : unicode) {
-    switch (c) {
-      case U'\t': add(U'\\'); add(U't'); break;
-      case U'\n': add(U'\\'); add(U'n'); break;
-      case U'\r': add(U'\\'); add(U'r'); break;
-      case U'>':
-      case U'\\': add(U'\\'); // fall through
-      default: add(c); break;
-    }
-  }
-  add('>');
-  return out;
-}
-
-static std::string ttl_string(boost::string_view text) {
-  using boost::locale::conv::utf_to_utf;
-  using boost::locale::utf::utf_traits;
-
-  std::string out;
-  out.reserve(2 + 2 * text.size());
-
-  std::back_insert_iterator<std::string> it(out);
-  auto add = [&](char32_t c) { utf_traits<char>::encode(c, it); };
-
-  const std::u32string unicode = utf_to_utf<char32_t>(
-      text.data(), text.data() + text.size());
-  add('"');
-  for (const char32_t c : unicode) {
-    switch (c) {
-      case U'\t': add(U'\\'); add(U't'); break;
-      case U'\n': add(U'\\'); add(U'n'); break;
-      case U'\r': add(U'\\'); add(U'r'); break;
-      case U'"':
-      case U'\\': add(U'\\'); // fall through
-      default: add(c); break;
-    }
-  }
-  add('"');
-  return out;
-}
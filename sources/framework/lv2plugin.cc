@@ -1,11 +1,52 @@
 #include "effect.h"
+#include "worker.h"
+#include "profiler.h"
+#include "telemetry.h"
 #include "description.h"
 #include "lv2all.h"
+#include "../variants.h"
 #include <boost/utility/string_view.hpp>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
 
+struct Instance {
+  Profiler profiler;
+  Worker worker;
+  std::unique_ptr<Effect> fx;
+};
+
+static LV2_Handle instantiate(
+    const LV2_Descriptor *descriptor,
+    double rate,
+    const char *bundle_path,
+    const LV2_Feature *const *features);
+static void connect_port(LV2_Handle instance, uint32_t port, void *data);
+static void activate(LV2_Handle instance);
+static void run(LV2_Handle instance, uint32_t nframes);
+static void deactivate(LV2_Handle instance);
+static void cleanup(LV2_Handle instance);
+static const void *extension_data(const char *uri_);
+
+// descriptors, one for each variant
+struct MakeEffectDescriptor {
+  template <class V> static constexpr LV2_Descriptor make() {
+    return LV2_Descriptor{
+      V::uri(),
+      instantiate,
+      connect_port,
+      activate,
+      run,
+      deactivate,
+      cleanup,
+      extension_data,
+    };
+  }
+};
+
+static constexpr ArrayRef<LV2_Descriptor> descriptors =
+    VariantTable<LV2_Descriptor, EffectVariantList, MakeEffectDescriptor>::data;
+
 static LV2_Handle instantiate(
     const LV2_Descriptor *descriptor,
     double rate,
@@ -14,6 +55,7 @@ static LV2_Handle instantiate(
   LV2_URID_Map *map {};
   LV2_URID_Unmap *unmap {};
   const LV2_Options_Option *opt {};
+  const LV2_Worker_Schedule *schedule {};
 
   for (const LV2_Feature *const *p = features, *f; (f = *p); ++p) {
     boost::string_view uri = f->URI;
@@ -23,69 +65,106 @@ static LV2_Handle instantiate(
       unmap = reinterpret_cast<LV2_URID_Unmap *>(f->data);
     } else if (uri == LV2_OPTIONS__options) {
       opt = reinterpret_cast<LV2_Options_Option *>(f->data);
+    } else if (uri == LV2_WORKER__schedule) {
+      schedule = reinterpret_cast<LV2_Worker_Schedule *>(f->data);
     }
   }
 
-  std::unique_ptr<Effect> fx;
+  const unsigned variant = descriptor - descriptors.data();
+
+  std::unique_ptr<Instance> self;
   try {
-    fx.reset(new Effect(rate, map, unmap, bundle_path));
+    self.reset(new Instance);
+    self->worker.set_schedule(schedule);
+    if (variant >= effect_factories.size())
+      throw std::runtime_error("unknown effect variant");
+    EffectFactory *create = effect_factories[variant];
+    self->fx.reset(create(rate, map, unmap, bundle_path, &self->worker));
+    Effect *fx = self->fx.get();
     if (opt)
       for (const LV2_Options_Option *optp = opt;
            optp->key || optp->value; ++optp)
         fx->option(*optp);
+    fx->prepare();
   } catch (std::exception &ex) {
     std::cerr << "error instanciating: " << ex.what() << "\n";
     return nullptr;
   }
-  return fx.release();
+  return self.release();
 }
 
 static void connect_port(LV2_Handle instance,
              uint32_t port,
              void *data) {
-  Effect *fx = reinterpret_cast<Effect *>(instance);
+  Effect *fx = reinterpret_cast<Instance *>(instance)->fx.get();
   fx->connect_port(port, data);
 }
 
 static void activate(LV2_Handle instance) {
-  Effect *fx = reinterpret_cast<Effect *>(instance);
+  Effect *fx = reinterpret_cast<Instance *>(instance)->fx.get();
   fx->activate();
 }
 
 static void run(LV2_Handle instance, uint32_t nframes) {
-  Effect *fx = reinterpret_cast<Effect *>(instance);
-  fx->run(nframes);
+  Instance *self = reinterpret_cast<Instance *>(instance);
+  self->profiler.register_thread();
+  self->fx->run(nframes);
 }
 
 static void deactivate(LV2_Handle instance) {
-  Effect *fx = reinterpret_cast<Effect *>(instance);
+  Effect *fx = reinterpret_cast<Instance *>(instance)->fx.get();
   fx->deactivate();
 }
 
 static void cleanup(LV2_Handle instance) {
-  Effect *fx = reinterpret_cast<Effect *>(instance);
-  delete fx;
+  Instance *self = reinterpret_cast<Instance *>(instance);
+  delete self;
 }
 
-static const void *extension_data(const char* uri) {
-  return nullptr;
+static LV2_Worker_Status work(LV2_Handle instance,
+                              LV2_Worker_Respond_Function respond,
+                              LV2_Worker_Respond_Handle handle,
+                              uint32_t size,
+                              const void *data) {
+  Instance *self = reinterpret_cast<Instance *>(instance);
+  return self->worker.work(
+      respond, handle,
+      [](void *fx, uint32_t type, const void *data, uint32_t size) {
+        reinterpret_cast<Effect *>(fx)->work(type, data, size); },
+      self->fx.get());
 }
 
-static const LV2_Descriptor descriptor = {
-  effect_uri,
-  instantiate,
-  connect_port,
-  activate,
-  run,
-  deactivate,
-  cleanup,
-  extension_data,
-};
+static LV2_Worker_Status work_response(LV2_Handle instance,
+                                       uint32_t size,
+                                       const void *data) {
+  Instance *self = reinterpret_cast<Instance *>(instance);
+  return self->worker.work_response(
+      [](void *fx, uint32_t type, const void *data, uint32_t size) {
+        reinterpret_cast<Effect *>(fx)->work_response(type, data, size); },
+      self->fx.get());
+}
+
+static TelemetryChannel *telemetry_channel(LV2_Handle instance) {
+  Effect *fx = reinterpret_cast<Instance *>(instance)->fx.get();
+  return fx->telemetry_channel();
+}
+
+static const void *extension_data(const char *uri_) {
+  boost::string_view uri = uri_;
+  if (uri == LV2_WORKER__interface) {
+    static const LV2_Worker_Interface intf = { &work, &work_response, nullptr };
+    return &intf;
+  }
+  if (uri == telemetry_channel_uri) {
+    static const TelemetryChannelInterface intf = { &telemetry_channel };
+    return &intf;
+  }
+  return nullptr;
+}
 
 LV2_SYMBOL_EXPORT
 const LV2_Descriptor *lv2_descriptor(uint32_t index) {
-  switch (index) {
-    case 0:  return &descriptor;
-    default: return nullptr;
-  }
+  if (index >= descriptors.size())
+    return nullptr;
+  return &descriptors[index];
 }
@@ -1,5 +1,6 @@
 #include "ui.h"
 #include "description.h"
+#include "telemetry.h"
 #include "lv2all.h"
 #include <boost/utility/string_view.hpp>
 #include <iostream>
@@ -18,6 +19,8 @@ static LV2UI_Handle instantiate(const LV2UI_Descriptor *descriptor,
   LV2UI_Resize *resize {};
   void *parent {};
   const LV2_Options_Option *opt {};
+  LV2_Handle instance {};
+  const LV2_Extension_Data_Feature *data_access {};
 
   for (const LV2_Feature *const *p = features, *f; (f = *p); ++p) {
     boost::string_view uri = f->URI;
@@ -31,22 +34,36 @@ static LV2UI_Handle instantiate(const LV2UI_Descriptor *descriptor,
       parent = f->data;
     } else if (uri == LV2_OPTIONS__options) {
       opt = reinterpret_cast<LV2_Options_Option *>(f->data);
+    } else if (uri == LV2_INSTANCE_ACCESS_URI) {
+      instance = f->data;
+    } else if (uri == LV2_DATA_ACCESS_URI) {
+      data_access = reinterpret_cast<LV2_Extension_Data_Feature *>(f->data);
     }
   }
 
   assert(map);
   assert(unmap);
 
+  // direct access to the telemetry of the effect, if the host permits
+  TelemetryChannel *telemetry {};
+  if (instance && data_access) {
+    const TelemetryChannelInterface *intf =
+        reinterpret_cast<const TelemetryChannelInterface *>(
+            data_access->data_access(telemetry_channel_uri));
+    if (intf)
+      telemetry = intf->channel(instance);
+  }
+
   std::unique_ptr<UI> ui;
   try {
-    ui.reset(new UI(parent, map, unmap, bundle_path));
+    ui.reset(new UI(parent, map, unmap, bundle_path, telemetry, resize));
     if (opt)
       for (const LV2_Options_Option *optp = opt;
            optp->key || optp->value; ++optp)
         ui->option(*optp);
     *widget = ui->widget();
     if (resize)
-      resize->ui_resize(resize->handle, UI::width(), UI::height());
+      resize->ui_resize(resize->handle, ui->width(), ui->height());
   } catch (std::exception &ex) {
     std::cerr << "error instanciating: " << ex.what() << "\n";
     *widget = nullptr;
@@ -72,6 +89,17 @@ static int idle(LV2UI_Handle handle) {
   return ui->idle();
 }
 
+static uint32_t get_options(LV2_Handle handle, LV2_Options_Option *options) {
+  return LV2_OPTIONS_ERR_UNKNOWN;
+}
+
+static uint32_t set_options(LV2_Handle handle, const LV2_Options_Option *options) {
+  UI *ui = reinterpret_cast<UI *>(handle);
+  for (const LV2_Options_Option *optp = options; optp->key || optp->value; ++optp)
+    ui->option(*optp);
+  return LV2_OPTIONS_SUCCESS;
+}
+
 static const void *extension_data(const char *uri_) {
   boost::string_view uri = uri_;
   if (uri == LV2_UI__idleInterface) {
@@ -79,6 +107,9 @@ static const void *extension_data(const char *uri_) {
       static const LV2UI_Idle_Interface intf = { &idle };
       return &intf;
     }
+  } else if (uri == LV2_OPTIONS__interface) {
+    static const LV2_Options_Interface intf = { &get_options, &set_options };
+    return &intf;
   }
   return nullptr;
 }
@@ -0,0 +1,65 @@
+#include "nvgbackend.h"
+#include <GL/glew.h>
+#include <nanovg.h>
+#include <nanovg_gl.h>
+
+static_assert(nvg_antialias == NVG_ANTIALIAS &&
+              nvg_stencil_strokes == NVG_STENCIL_STROKES &&
+              nvg_debug == NVG_DEBUG, "the flags must match those of NanoVG");
+
+extern "C" {
+NVGcontext *nvgCreateGL2(int flags);
+void nvgDeleteGL2(NVGcontext *ctx);
+NVGLUframebuffer *nvgluCreateFramebufferGL2(NVGcontext *ctx, int w, int h, int imageFlags);
+void nvgluBindFramebufferGL2(NVGLUframebuffer *fb);
+void nvgluDeleteFramebufferGL2(NVGLUframebuffer *fb);
+
+NVGcontext *nvgCreateGL3(int flags);
+void nvgDeleteGL3(NVGcontext *ctx);
+NVGLUframebuffer *nvgluCreateFramebufferGL3(NVGcontext *ctx, int w, int h, int imageFlags);
+void nvgluBindFramebufferGL3(NVGLUframebuffer *fb);
+void nvgluDeleteFramebufferGL3(NVGLUframebuffer *fb);
+}
+
+static bool gl2_has_framebuffers() {
+  return GLEW_VERSION_3_0 || GLEW_ARB_framebuffer_object;
+}
+
+static bool gl3_has_framebuffers() {
+  return true;
+}
+
+static const NvgBackend gl2_backend = {
+  "GL2",
+  &nvgCreateGL2,
+  &nvgDeleteGL2,
+  &gl2_has_framebuffers,
+  &nvgluCreateFramebufferGL2,
+  &nvgluBindFramebufferGL2,
+  &nvgluDeleteFramebufferGL2,
+};
+
+static const NvgBackend gl3_backend = {
+  "GL3",
+  &nvgCreateGL3,
+  &nvgDeleteGL3,
+  &gl3_has_framebuffers,
+  &nvgluCreateFramebufferGL3,
+  &nvgluBindFramebufferGL3,
+  &nvgluDeleteFramebufferGL3,
+};
+
+const NvgBackend &nvg_backend() {
+  // the shaders of the GL3 backend are GLSL 1.50, which requires GL 3.2
+  if (GLEW_VERSION_3_2)
+    return gl3_backend;
+  return gl2_backend;
+}
+
+const NvgBackend &nvg_gl2_backend() {
+  return gl2_backend;
+}
+
+const NvgBackend &nvg_gl3_backend() {
+  return gl3_backend;
+}
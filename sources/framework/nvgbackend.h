@@ -0,0 +1,36 @@
+#pragma once
+
+struct NVGcontext;
+struct NVGLUframebuffer;
+
+// Table of the functions of a NanoVG OpenGL backend
+//
+// The UI module contains the GL2 and GL3 backends. The GL3 one, which uses
+// vertex arrays and uniform buffers, is selected at run time if the context
+// supports it.
+struct NvgBackend {
+  const char *name;
+
+  NVGcontext *(*create)(int flags);
+  void (*destroy)(NVGcontext *vg);
+
+  // whether the current context has framebuffer objects, which GL2 has only
+  // from GL 3.0 or with ARB_framebuffer_object
+  bool (*has_framebuffers)();
+  NVGLUframebuffer *(*create_framebuffer)(NVGcontext *vg, int width, int height, int image_flags);
+  // bind the framebuffer, or the default one if null
+  void (*bind_framebuffer)(NVGLUframebuffer *fb);
+  void (*delete_framebuffer)(NVGLUframebuffer *fb);
+};
+
+// flags of `create`, the values of NVGcreateFlags of nanovg_gl.h
+constexpr int nvg_antialias = 1 << 0;
+constexpr int nvg_stencil_strokes = 1 << 1;
+constexpr int nvg_debug = 1 << 2;
+
+// get the best backend for the current context, after GLEW is initialized
+const NvgBackend &nvg_backend();
+
+// get the backends by version
+const NvgBackend &nvg_gl2_backend();
+const NvgBackend &nvg_gl3_backend();
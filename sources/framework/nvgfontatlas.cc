@@ -0,0 +1,452 @@
+#include "nvgfontatlas.h"
+#include "fontatlas.h"
+#include <nanovg.h>
+#include <algorithm>
+#include <utility>
+#include <iostream>
+#include <cstring>
+#include <cmath>
+
+// decode the next codepoint of UTF-8 text, or return false at the end
+static bool next_codepoint(const char *&p, const char *end, uint32_t &codepoint) {
+  if (p == end)
+    return false;
+  unsigned char c = *p++;
+  unsigned extra = (c >= 0xf0) ? 3 : (c >= 0xe0) ? 2 : (c >= 0xc0) ? 1 : 0;
+  codepoint = (extra == 0) ? c : (c & (0x3f >> extra));
+  for (; extra > 0 && p != end && (*p & 0xc0) == 0x80; --extra)
+    codepoint = (codepoint << 6) | (*p++ & 0x3f);
+  return true;
+}
+
+static const FontAtlasGlyph *find_glyph(const FontAtlasFace &face, uint32_t codepoint) {
+  const FontAtlasGlyph *begin = face.glyphs, *end = begin + face.glyph_count;
+  const FontAtlasGlyph *glyph = std::lower_bound(
+      begin, end, codepoint, [](const FontAtlasGlyph &g, uint32_t c) { return g.codepoint < c; });
+  return (glyph != end && glyph->codepoint == codepoint) ? glyph : nullptr;
+}
+
+static int find_kerning(const FontAtlasFace &face, uint32_t first, uint32_t second) {
+  const FontAtlasKerning *begin = face.kerning, *end = begin + face.kerning_count;
+  const FontAtlasKerning *kerning = std::lower_bound(
+      begin, end, std::make_pair(first, second),
+      [](const FontAtlasKerning &k, const std::pair<uint32_t, uint32_t> &p) {
+        return k.first < p.first || (k.first == p.first && k.second < p.second); });
+  return (kerning != end && kerning->first == first && kerning->second == second) ?
+      kerning->advance : 0;
+}
+
+//==============================================================================
+constexpr size_t NvgFontAtlas::layout_cache_capacity;
+
+bool NvgFontAtlas::init(NVGcontext *vg, const FontAtlasData &data) {
+  data_ = &data;
+  image_ = 0;
+  layouts_.clear();
+  for (Fallback &fallback : fallbacks_)
+    fallback.loaded = false;
+  if (data.face_count == 0)
+    return true;
+
+  // white pixels, whose alpha is the coverage
+  std::vector<unsigned char> rgba(4 * data.width * data.height, 0xff);
+  for (unsigned i = 0, n = data.width * data.height; i < n; ++i)
+    rgba[4 * i + 3] = data.pixels[i];
+
+  image_ = nvgCreateImageRGBA(vg, data.width, data.height, 0, rgba.data());
+  if (!image_) {
+    std::cerr << "error creating the image of the font atlas\n";
+    return false;
+  }
+  return true;
+}
+
+void NvgFontAtlas::add_fallback(const char *face, const unsigned char *data, unsigned size) {
+  Fallback fallback;
+  fallback.face = face;
+  fallback.data = data;
+  fallback.size = size;
+  fallbacks_.push_back(fallback);
+}
+
+float NvgFontAtlas::text(NVGcontext *vg, const char *face, float size, int align, const NVGcolor &color,
+                         float x, float y, const char *string, const char *end) {
+  if (!end)
+    end = string + std::strlen(string);
+
+  const FontAtlasFace *atlas_face = find_face(face, size);
+  const Layout *layout = atlas_face ? find_layout(atlas_face, 0, string, end) : nullptr;
+  if (!layout) {
+    load_fallback(vg, face, size, align, color);
+    return nvgText(vg, x, y, string, end);
+  }
+
+  // the layout is in device pixels
+  const float unit = 1 / pixel_ratio_;
+  const Line &line = layout->lines[0];
+  if (align & NVG_ALIGN_CENTER)
+    x -= line.advance * unit * 0.5f;
+  else if (align & NVG_ALIGN_RIGHT)
+    x -= line.advance * unit;
+  y += vertical_offset(*atlas_face, align);
+
+  for (unsigned i = line.first; i < line.first + line.count; ++i) {
+    const Quad &quad = layout->quads[i];
+    add_glyph(*quad.glyph, x + quad.x * unit, y);
+  }
+  flush_glyphs(vg, color);
+  return x + line.advance * unit;
+}
+
+void NvgFontAtlas::text_box(NVGcontext *vg, const char *face, float size, int align, const NVGcolor &color,
+                            float x, float y, float box_width, const char *string, const char *end) {
+  if (!end)
+    end = string + std::strlen(string);
+
+  const FontAtlasFace *atlas_face = find_face(face, size);
+  const Layout *layout = atlas_face ?
+      find_layout(atlas_face, box_width * pixel_ratio_, string, end) : nullptr;
+  if (!layout) {
+    load_fallback(vg, face, size, align, color);
+    nvgTextBox(vg, x, y, box_width, string, end);
+    return;
+  }
+
+  // the lines are aligned in the box, as `nvgTextBox` does
+  const float unit = 1 / pixel_ratio_;
+  y += vertical_offset(*atlas_face, align);
+  for (const Line &line : layout->lines) {
+    float lx = x;
+    if (align & NVG_ALIGN_CENTER)
+      lx += box_width * 0.5f - line.width * unit * 0.5f;
+    else if (align & NVG_ALIGN_RIGHT)
+      lx += box_width - line.width * unit;
+    for (unsigned i = line.first; i < line.first + line.count; ++i) {
+      const Quad &quad = layout->quads[i];
+      add_glyph(*quad.glyph, lx + quad.x * unit, y);
+    }
+    y += atlas_face->line_height * unit;
+  }
+  flush_glyphs(vg, color);
+}
+
+float NvgFontAtlas::text_width(NVGcontext *vg, const char *face, float size, const char *string, const char *end) {
+  if (!end)
+    end = string + std::strlen(string);
+
+  const FontAtlasFace *atlas_face = find_face(face, size);
+  const Layout *layout = atlas_face ? find_layout(atlas_face, 0, string, end) : nullptr;
+  if (!layout) {
+    nvgSave(vg);
+    load_fallback(vg, face, size, NVG_ALIGN_LEFT|NVG_ALIGN_BASELINE, nvgRGB(0, 0, 0));
+    float width = nvgTextBounds(vg, 0, 0, string, end, nullptr);
+    nvgRestore(vg);
+    return width;
+  }
+  return layout->lines[0].advance / pixel_ratio_;
+}
+
+void NvgFontAtlas::set_pixel_ratio(float ratio) {
+  pixel_ratio_ = ratio;
+}
+
+const FontAtlasFace *NvgFontAtlas::find_face(const char *name, float size) const {
+  if (!image_)
+    return nullptr;
+  // the face which is baked at the size in device pixels
+  size *= pixel_ratio_;
+  const FontAtlasData &data = *data_;
+  for (unsigned i = 0; i < data.face_count; ++i) {
+    const FontAtlasFace &face = data.faces[i];
+    if (face.size == size && std::strcmp(face.name, name) == 0)
+      return &face;
+  }
+  return nullptr;
+}
+
+const NvgFontAtlas::Layout *NvgFontAtlas::find_layout(
+    const FontAtlasFace *face, float box_width, const char *string, const char *end) {
+  const size_t length = end - string;
+
+  // FNV-1a of the key, which does not allocate at the lookup
+  uint64_t hash = 14695981039346656037u;
+  auto mix = [&hash](const void *data, size_t size) {
+    for (size_t i = 0; i < size; ++i)
+      hash = (hash ^ reinterpret_cast<const uint8_t *>(data)[i]) * 1099511628211u;
+  };
+  mix(&face, sizeof(face));
+  mix(&box_width, sizeof(box_width));
+  mix(string, length);
+
+  auto range = layouts_.equal_range(size_t(hash));
+  for (auto it = range.first; it != range.second; ++it) {
+    const Layout &layout = it->second;
+    if (layout.face == face && layout.box_width == box_width &&
+        layout.text.size() == length && std::memcmp(layout.text.data(), string, length) == 0)
+      return layout.lines.empty() ? nullptr : &layout;
+  }
+
+  if (layouts_.size() >= layout_cache_capacity)
+    layouts_.clear();
+
+  // a failed layout is cached too, empty, for the text which falls back
+  Layout layout;
+  layout.face = face;
+  layout.box_width = box_width;
+  layout.text.assign(string, end);
+  if (!make_layout(layout, string, end)) {
+    layout.quads.clear();
+    layout.lines.clear();
+  }
+  const Layout &cached = layouts_.emplace(size_t(hash), std::move(layout))->second;
+  return cached.lines.empty() ? nullptr : &cached;
+}
+
+// place the glyphs with the advances and kerning of fontstash, and if there
+// is a box width, break the lines at the spaces or else inside the words
+bool NvgFontAtlas::make_layout(Layout &layout, const char *string, const char *end) {
+  const FontAtlasFace &face = *layout.face;
+  const bool wrap = layout.box_width > 0;
+  std::vector<Quad> &quads = layout.quads;
+  std::vector<Line> &lines = layout.lines;
+
+  unsigned line_start = 0;
+  unsigned word_start = 0;
+  bool in_word = false;
+  float pen = 0;
+  uint32_t codepoint, previous = 0;
+
+  auto finish_line = [&](unsigned line_end, float advance) {
+    Line line;
+    line.first = line_start;
+    line.count = line_end - line_start;
+    line.advance = advance;
+    // the width excludes the trailing spaces
+    line.width = 0;
+    for (unsigned i = line_end; i-- > line_start;) {
+      const Quad &quad = quads[i];
+      if (quad.glyph->codepoint != ' ') {
+        line.width = quad.x + quad.glyph->advance;
+        break;
+      }
+    }
+    lines.push_back(line);
+  };
+
+  for (const char *p = string; next_codepoint(p, end, codepoint);) {
+    if (wrap && codepoint == '\n') {
+      finish_line(quads.size(), pen);
+      line_start = quads.size();
+      pen = 0;
+      previous = 0;
+      in_word = false;
+      continue;
+    }
+
+    const FontAtlasGlyph *glyph = find_glyph(face, codepoint);
+    if (!glyph)
+      return false;
+
+    float x = pen + (previous ? find_kerning(face, previous, codepoint) : 0);
+    bool space = codepoint == ' ';
+    if (!space && !in_word)
+      word_start = quads.size();
+    in_word = !space;
+
+    if (wrap && !space && x + glyph->advance > layout.box_width && quads.size() > line_start) {
+      // move the current word to the next line, or break it if it fills the line
+      unsigned break_at = (word_start > line_start) ? word_start : quads.size();
+      float shift = (break_at < quads.size()) ? quads[break_at].x : x;
+      finish_line(break_at, shift);
+      for (unsigned i = break_at; i < quads.size(); ++i)
+        quads[i].x -= shift;
+      x -= shift;
+      line_start = word_start = break_at;
+    }
+
+    quads.push_back(Quad{glyph, x});
+    pen = x + glyph->advance;
+    previous = codepoint;
+  }
+  finish_line(quads.size(), pen);
+  return true;
+}
+
+void NvgFontAtlas::add_glyph(const FontAtlasGlyph &glyph, float x, float y) {
+  if (glyph.width == 0 || glyph.height == 0)
+    return;
+  const FontAtlasData &data = *data_;
+  // the glyph is snapped to the device pixels
+  const float ratio = pixel_ratio_, unit = 1 / ratio;
+  float gx = std::floor(x * ratio + glyph.left);
+  float gy = std::floor(y * ratio + glyph.top);
+  float x0 = gx * unit, y0 = gy * unit;
+  float x1 = (gx + glyph.width) * unit, y1 = (gy + glyph.height) * unit;
+  float u0 = float(glyph.x) / data.width, v0 = float(glyph.y) / data.height;
+  float u1 = float(glyph.x + glyph.width) / data.width;
+  float v1 = float(glyph.y + glyph.height) / data.height;
+  // two triangles, in the order of `nvgText`
+  vertices_.push_back(Vertex{x0, y0, u0, v0});
+  vertices_.push_back(Vertex{x1, y1, u1, v1});
+  vertices_.push_back(Vertex{x1, y0, u1, v0});
+  vertices_.push_back(Vertex{x0, y0, u0, v0});
+  vertices_.push_back(Vertex{x0, y1, u0, v1});
+  vertices_.push_back(Vertex{x1, y1, u1, v1});
+}
+
+void NvgFontAtlas::flush_glyphs(NVGcontext *vg, const NVGcolor &color) {
+  if (vertices_.empty())
+    return;
+
+  // the vertices in the coordinates of the frame
+  float xform[6];
+  nvgCurrentTransform(vg, xform);
+  for (Vertex &vertex : vertices_)
+    nvgTransformPoint(&vertex.x, &vertex.y, xform, vertex.x, vertex.y);
+
+  // the atlas is tinted by the inner color, like the font image of `nvgText`
+  NVGpaint paint = nvgImagePattern(vg, 0, 0, data_->width, data_->height, 0, image_, 1);
+  paint.innerColor = paint.outerColor = color;
+  // the default composite operation, source over
+  NVGcompositeOperationState composite;
+  composite.srcRGB = composite.srcAlpha = NVG_ONE;
+  composite.dstRGB = composite.dstAlpha = NVG_ONE_MINUS_SRC_ALPHA;
+  // a negative extent disables the scissor
+  NVGscissor scissor;
+  nvgTransformIdentity(scissor.xform);
+  scissor.extent[0] = scissor.extent[1] = -1.0f;
+
+  static_assert(sizeof(Vertex) == sizeof(NVGvertex), "the vertex must be a NVGvertex");
+  const NVGparams &params = *nvgInternalParams(vg);
+  params.renderTriangles(
+      params.userPtr, &paint, composite, &scissor,
+      reinterpret_cast<const NVGvertex *>(vertices_.data()), int(vertices_.size()),
+      1 / pixel_ratio_);
+  vertices_.clear();
+}
+
+float NvgFontAtlas::vertical_offset(const FontAtlasFace &face, int align) const {
+  const float unit = 1 / pixel_ratio_;
+  if (align & NVG_ALIGN_TOP)
+    return face.ascender * unit;
+  if (align & NVG_ALIGN_MIDDLE)
+    return (face.ascender + face.descender) * unit * 0.5f;
+  if (align & NVG_ALIGN_BOTTOM)
+    return face.descender * unit;
+  return 0;
+}
+
+void NvgFontAtlas::load_fallback(NVGcontext *vg, const char *face, float size, int align, const NVGcolor &color) {
+  for (Fallback &fallback : fallbacks_) {
+    if (!fallback.loaded && fallback.face == face) {
+      nvgCreateFontMem(
+          vg, face, const_cast<unsigned char *>(fallback.data), fallback.size, false);
+      fallback.loaded = true;
+    }
+  }
+  nvgFontFace(vg, face);
+  nvgFontSize(vg, size);
+  nvgTextAlign(vg, align);
+  nvgFillColor(vg, color);
+}
+
+//==============================================================================
+NvgReadout::NvgReadout(NvgFontAtlas &fonts, const char *face, float size, unsigned cells)
+    : fonts_(fonts), face_name_(face), size_(size), cells_(cells) {
+  text_.reserve(4 * cells);
+}
+
+void NvgReadout::set(const char *text) {
+  const char *p = text, *end = text + std::strlen(text);
+  unsigned count = 0;
+  uint32_t codepoint;
+  while (count < cells_.size() && next_codepoint(p, end, codepoint)) {
+    Cell &cell = cells_[count++];
+    if (cell.codepoint != codepoint) {
+      cell.codepoint = codepoint;
+      cell.dirty = true;
+    }
+  }
+  count_ = count;
+  text_.assign(text, p);
+}
+
+void NvgReadout::draw(NVGcontext *vg, int align, const NVGcolor &color, float x, float y) {
+  if (!resolve()) {
+    // draw the characters one by one, centered in cells of the fallback font
+    float cell_width = width(vg) / std::max(1u, count_);
+    int vertical = align & (NVG_ALIGN_TOP|NVG_ALIGN_MIDDLE|NVG_ALIGN_BOTTOM|NVG_ALIGN_BASELINE);
+    fonts_.load_fallback(vg, face_name_.c_str(), size_, vertical|NVG_ALIGN_CENTER, color);
+    if (align & NVG_ALIGN_CENTER)
+      x -= cell_width * count_ * 0.5f;
+    else if (align & NVG_ALIGN_RIGHT)
+      x -= cell_width * count_;
+    const char *p = text_.data(), *end = p + text_.size();
+    uint32_t codepoint;
+    for (unsigned i = 0; i < count_; ++i) {
+      const char *start = p;
+      next_codepoint(p, end, codepoint);
+      nvgText(vg, x + (i + 0.5f) * cell_width, y, start, p);
+    }
+    return;
+  }
+
+  // the cells are in device pixels
+  const float ratio = fonts_.pixel_ratio_, unit = 1 / ratio;
+  const float w = cell_width_ * count_ * unit;
+  if (align & NVG_ALIGN_CENTER)
+    x -= w * 0.5f;
+  else if (align & NVG_ALIGN_RIGHT)
+    x -= w;
+  x = std::floor(x * ratio) * unit;
+  y += fonts_.vertical_offset(*face_, align);
+
+  for (unsigned i = 0; i < count_; ++i) {
+    const Cell &cell = cells_[i];
+    fonts_.add_glyph(*cell.glyph, x + (i * cell_width_ + cell.offset) * unit, y);
+  }
+  fonts_.flush_glyphs(vg, color);
+}
+
+float NvgReadout::width(NVGcontext *vg) {
+  if (resolve())
+    return cell_width_ * count_ / fonts_.pixel_ratio_;
+  nvgSave(vg);
+  fonts_.load_fallback(vg, face_name_.c_str(), size_, NVG_ALIGN_LEFT|NVG_ALIGN_BASELINE, nvgRGB(0, 0, 0));
+  float width = nvgTextBounds(vg, 0, 0, "0", nullptr, nullptr) * count_;
+  nvgRestore(vg);
+  return width;
+}
+
+bool NvgReadout::resolve() {
+  // find the face when the atlas is initialized, or again if it is replaced
+  // or the pixel ratio changes
+  if (resolved_data_ != fonts_.data_ || resolved_ratio_ != fonts_.pixel_ratio_ ||
+      (face_ && !fonts_.image_)) {
+    resolved_data_ = fonts_.data_;
+    resolved_ratio_ = fonts_.pixel_ratio_;
+    face_ = fonts_.find_face(face_name_.c_str(), size_);
+    cell_width_ = 0;
+    for (uint32_t digit = '0'; face_ && digit <= '9'; ++digit) {
+      const FontAtlasGlyph *glyph = find_glyph(*face_, digit);
+      cell_width_ = glyph ? std::max(cell_width_, float(glyph->advance)) : cell_width_;
+    }
+    for (Cell &cell : cells_)
+      cell.dirty = true;
+  }
+  if (!face_)
+    return false;
+
+  // update the glyphs of the cells which changed
+  for (unsigned i = 0; i < count_; ++i) {
+    Cell &cell = cells_[i];
+    if (!cell.dirty)
+      continue;
+    cell.glyph = find_glyph(*face_, cell.codepoint);
+    if (!cell.glyph)
+      return false;
+    cell.offset = std::floor((cell_width_ - cell.glyph->advance) * 0.5f);
+    cell.dirty = false;
+  }
+  return true;
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct NVGcontext;
+struct NVGcolor;
+struct FontAtlasData;
+struct FontAtlasFace;
+struct FontAtlasGlyph;
+
+// Text drawing with the glyphs of a prebaked atlas (see fontatlas.h)
+//
+// The atlas is uploaded as a single image, so the text is ready to draw
+// without parsing or rasterizing fonts at run time. The text which is not in
+// the atlas, with a face and size or glyphs which were not baked, is drawn by
+// NanoVG with the fallback fonts, which are loaded when first needed.
+// The layouts of the text are cached by string, face, size and box width, so
+// the labels are measured and broken into lines only once. For the values
+// which change at every frame, use a `NvgReadout` rather than the cache.
+// With a pixel ratio other than 1, the text uses the faces baked at the size
+// in device pixels, like "sans" 24 for "sans" 12 at a ratio of 2, and falls
+// back to the fonts if there is none.
+// The glyphs of a call are drawn in a single batch of triangles, as `nvgText`
+// does; since the state of NanoVG is private, the batch follows the
+// transform, but not the scissor, the global alpha, or the composite
+// operation.
+// The functions require the GL context to be current.
+class NvgFontAtlas {
+ public:
+  NvgFontAtlas() {}
+
+  NvgFontAtlas(const NvgFontAtlas &) = delete;
+  NvgFontAtlas &operator=(const NvgFontAtlas &) = delete;
+
+  // create the image of the atlas in the NanoVG context
+  bool init(NVGcontext *vg, const FontAtlasData &data);
+
+  // set the font of a face for the fallback, the data must remain valid
+  void add_fallback(const char *face, const unsigned char *data, unsigned size);
+
+  // draw a line of text like `nvgText` with the given style, and return the
+  // horizontal position of its end; this replaces the fill of the state
+  float text(NVGcontext *vg, const char *face, float size, int align, const NVGcolor &color,
+             float x, float y, const char *string, const char *end = nullptr);
+
+  // draw text broken into lines of the box width, like `nvgTextBox`
+  void text_box(NVGcontext *vg, const char *face, float size, int align, const NVGcolor &color,
+                float x, float y, float box_width, const char *string, const char *end = nullptr);
+
+  // measure the advance of a line of text
+  float text_width(NVGcontext *vg, const char *face, float size, const char *string, const char *end = nullptr);
+
+  // set the ratio of device pixels to units, for the frames which follow
+  void set_pixel_ratio(float ratio);
+  float pixel_ratio() const { return pixel_ratio_; }
+
+  // the maximum count of cached layouts, beyond which the cache is emptied
+  static constexpr size_t layout_cache_capacity = 1024;
+
+ private:
+  friend class NvgReadout;
+
+  struct Quad {
+    const FontAtlasGlyph *glyph;
+    float x;
+  };
+
+  struct Line {
+    unsigned first, count;
+    float width;
+    float advance;
+  };
+
+  struct Layout {
+    const FontAtlasFace *face;
+    float box_width;
+    std::string text;
+    std::vector<Quad> quads;
+    std::vector<Line> lines;
+  };
+
+  const FontAtlasFace *find_face(const char *name, float size) const;
+  const Layout *find_layout(const FontAtlasFace *face, float box_width, const char *string, const char *end);
+  static bool make_layout(Layout &layout, const char *string, const char *end);
+  void add_glyph(const FontAtlasGlyph &glyph, float x, float y);
+  void flush_glyphs(NVGcontext *vg, const NVGcolor &color);
+  float vertical_offset(const FontAtlasFace &face, int align) const;
+  void load_fallback(NVGcontext *vg, const char *face, float size, int align, const NVGcolor &color);
+
+  struct Fallback {
+    std::string face;
+    const unsigned char *data = nullptr;
+    unsigned size = 0;
+    bool loaded = false;
+  };
+
+  // vertices of the glyphs of the batch, with the layout of NVGvertex
+  struct Vertex {
+    float x, y, u, v;
+  };
+
+  const FontAtlasData *data_ = nullptr;
+  int image_ = 0;
+  std::vector<Vertex> vertices_;
+  float pixel_ratio_ = 1;
+  std::vector<Fallback> fallbacks_;
+  std::unordered_multimap<size_t, Layout> layouts_;
+};
+
+// Numeric readout, with the characters in cells of the width of a digit
+//
+// The cells have fixed positions, so setting the text only replaces the
+// glyphs of the cells which changed, and the digits do not move as they
+// change. Characters beyond the count of cells are dropped.
+class NvgReadout {
+ public:
+  NvgReadout(NvgFontAtlas &fonts, const char *face, float size, unsigned cells);
+
+  void set(const char *text);
+  const char *text() const { return text_.c_str(); }
+
+  // draw the readout, aligned by the cells of its current text
+  void draw(NVGcontext *vg, int align, const NVGcolor &color, float x, float y);
+
+  // the horizontal extent of the current text
+  float width(NVGcontext *vg);
+
+ private:
+  bool resolve();
+
+  struct Cell {
+    uint32_t codepoint = 0;
+    const FontAtlasGlyph *glyph = nullptr;
+    float offset = 0;
+    bool dirty = true;
+  };
+
+  NvgFontAtlas &fonts_;
+  std::string face_name_;
+  float size_ = 0;
+  const FontAtlasFace *face_ = nullptr;
+  const FontAtlasData *resolved_data_ = nullptr;
+  float resolved_ratio_ = 0;
+  float cell_width_ = 0;
+  std::vector<Cell> cells_;
+  unsigned count_ = 0;
+  std::string text_;
+};
@@ -0,0 +1,85 @@
+#include "nvglayer.h"
+#include "nvgbackend.h"
+#include <GL/glew.h>
+#include <nanovg.h>
+#include <nanovg_gl_utils.h>
+#include <iostream>
+#include <cmath>
+
+NvgLayer::~NvgLayer() {
+  release();
+}
+
+void NvgLayer::resize(float width, float height, float pixel_ratio) {
+  if (width == width_ && height == height_ && pixel_ratio == pixel_ratio_)
+    return;
+  width_ = width;
+  height_ = height;
+  pixel_ratio_ = pixel_ratio;
+  dirty_ = true;
+}
+
+void NvgLayer::draw(NVGcontext *vg, float x, float y, float alpha) const {
+  if (!fb_)
+    return;
+  NVGpaint paint = nvgImagePattern(vg, x, y, width_, height_, 0, fb_->image, alpha);
+  nvgBeginPath(vg);
+  nvgRect(vg, x, y, width_, height_);
+  nvgFillPaint(vg, paint);
+  nvgFill(vg);
+}
+
+void NvgLayer::release() {
+  if (fb_) {
+    backend_->delete_framebuffer(fb_);
+    fb_ = nullptr;
+  }
+  dirty_ = true;
+}
+
+bool NvgLayer::begin_update(const NvgBackend &backend, NVGcontext *vg) {
+  if (!dirty_)
+    return false;
+
+  int fb_width = int(std::ceil(width_ * pixel_ratio_));
+  int fb_height = int(std::ceil(height_ * pixel_ratio_));
+  if (fb_width <= 0 || fb_height <= 0)
+    return false;
+
+  if (!fb_ || &backend != backend_ || fb_width != fb_width_ || fb_height != fb_height_) {
+    release();
+    if (!backend.has_framebuffers())
+      return false;
+    fb_ = backend.create_framebuffer(vg, fb_width, fb_height, 0);
+    if (!fb_) {
+      std::cerr << "error creating a NanoVG framebuffer\n";
+      return false;
+    }
+    backend_ = &backend;
+    fb_width_ = fb_width;
+    fb_height_ = fb_height;
+  }
+
+  backend_->bind_framebuffer(fb_);
+  glViewport(0, 0, fb_width, fb_height);
+  glClearColor(0, 0, 0, 0);
+  glClear(GL_COLOR_BUFFER_BIT|GL_STENCIL_BUFFER_BIT);
+  nvgBeginFrame(vg, width_, height_, pixel_ratio_);
+  return true;
+}
+
+void NvgLayer::end_update(NVGcontext *vg) {
+  nvgEndFrame(vg);
+  backend_->bind_framebuffer(nullptr);
+  dirty_ = false;
+}
+
+void NvgLayer::begin_paint(NVGcontext *vg, float x, float y) const {
+  nvgSave(vg);
+  nvgTranslate(vg, x, y);
+  nvgIntersectScissor(vg, 0, 0, width_, height_);
+}
+
+void NvgLayer::end_paint(NVGcontext *vg) const {
+  nvgRestore(vg);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <utility>
+
+struct NVGcontext;
+struct NVGLUframebuffer;
+struct NvgBackend;
+
+// Part of a NanoVG drawing, cached in a framebuffer
+//
+// A layer holds the rendering of content which rarely changes. The content is
+// painted again only after the layer is invalidated or resized; otherwise the
+// frame just composites the cached image.
+// Without support of framebuffers, or if one cannot be created, the layer
+// holds nothing, and its content is painted directly in each frame.
+// All the functions require the GL context to be current. The updates must
+// happen outside of a frame, and the drawing inside one.
+class NvgLayer {
+ public:
+  NvgLayer() {}
+  ~NvgLayer();
+
+  NvgLayer(const NvgLayer &) = delete;
+  NvgLayer &operator=(const NvgLayer &) = delete;
+
+  // set the size in logical units, and the ratio of device pixels to units
+  // the layer is invalidated only if these change
+  void resize(float width, float height, float pixel_ratio);
+  void invalidate() { dirty_ = true; }
+  bool dirty() const { return dirty_; }
+
+  // if the layer is invalid, paint it with `paint(vg)` in its own coordinates
+  template <class Paint>
+  void update(const NvgBackend &backend, NVGcontext *vg, Paint &&paint);
+
+  // composite the layer at the given position of the frame
+  void draw(NVGcontext *vg, float x, float y, float alpha = 1) const;
+
+  // composite the layer, or paint it with `paint(vg)` if it holds nothing
+  template <class Paint>
+  void draw_or_paint(NVGcontext *vg, float x, float y, Paint &&paint) const;
+
+  // delete the framebuffer, before the NanoVG context is deleted
+  void release();
+
+ private:
+  bool begin_update(const NvgBackend &backend, NVGcontext *vg);
+  void end_update(NVGcontext *vg);
+  void begin_paint(NVGcontext *vg, float x, float y) const;
+  void end_paint(NVGcontext *vg) const;
+
+  const NvgBackend *backend_ = nullptr;
+  NVGLUframebuffer *fb_ = nullptr;
+  float width_ = 0;
+  float height_ = 0;
+  float pixel_ratio_ = 1;
+  int fb_width_ = 0;
+  int fb_height_ = 0;
+  bool dirty_ = true;
+};
+
+template <class Paint>
+void NvgLayer::update(const NvgBackend &backend, NVGcontext *vg, Paint &&paint) {
+  if (!begin_update(backend, vg))
+    return;
+  std::forward<Paint>(paint)(vg);
+  end_update(vg);
+}
+
+template <class Paint>
+void NvgLayer::draw_or_paint(NVGcontext *vg, float x, float y, Paint &&paint) const {
+  if (fb_)
+    return draw(vg, x, y);
+  begin_paint(vg, x, y);
+  std::forward<Paint>(paint)(vg);
+  end_paint(vg);
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include "description.h"
+#include "lv2all.h"
+#include <type_traits>
+#include <cstdint>
+
+// A list of ports, declared once as types in the order of their indices.
+//
+// Each port type provides its manifest record:
+//
+//   struct AudioOutput {
+//     static constexpr Port record()
+//       { return audio_port(PortDirection::Output, "out", "Output"); }
+//   };
+//
+// The list generates the manifest records, a structure of typed pointers to
+// the buffers, and a table which connects the buffers by index.
+
+//==============================================================================
+template <PortKind Kind, PortDirection Direction> struct PortBufferType;
+
+template <> struct PortBufferType<PortKind::Audio, PortDirection::Input> {
+  typedef const float *type;
+};
+template <> struct PortBufferType<PortKind::Audio, PortDirection::Output> {
+  typedef float *type;
+};
+template <> struct PortBufferType<PortKind::Control, PortDirection::Input> {
+  typedef const float *type;
+};
+template <> struct PortBufferType<PortKind::Control, PortDirection::Output> {
+  typedef float *type;
+};
+template <> struct PortBufferType<PortKind::Event, PortDirection::Input> {
+  typedef const LV2_Atom_Sequence *type;
+};
+template <> struct PortBufferType<PortKind::Event, PortDirection::Output> {
+  typedef LV2_Atom_Sequence *type;
+};
+
+template <class P>
+using PortBuffer = typename PortBufferType<P::record().kind, P::record().direction>::type;
+
+//==============================================================================
+template <class P>
+struct PortSlot {
+  PortBuffer<P> buffer = nullptr;
+};
+
+template <class... P>
+class PortList {
+ public:
+  static constexpr unsigned size = sizeof...(P);
+
+  // the manifest records, in the order of indices
+  static constexpr Port records[] = { P::record()... };
+
+  // the index of the port type Q
+  template <class Q> static constexpr uint32_t index();
+
+  // the buffers of the ports, addressed by type
+  struct Ports : PortSlot<P>... {
+    template <class Q> PortBuffer<Q> get() const {
+      return static_cast<const PortSlot<Q> &>(*this).buffer;
+    }
+  };
+
+  // sets the buffer of the port at the given index
+  static void connect(Ports &ports, uint32_t index, void *data) {
+    typedef void (Connect)(Ports &, void *);
+    static constexpr Connect *table[] = { &connect_slot<P>... };
+    if (index < size)
+      table[index](ports, data);
+  }
+
+ private:
+  template <class Q> static void connect_slot(Ports &ports, void *data) {
+    static_cast<PortSlot<Q> &>(ports).buffer = static_cast<PortBuffer<Q>>(data);
+  }
+  template <class Q, class... R> struct IndexOf;
+  template <class Q, class... R> struct IndexOf<Q, Q, R...>
+      : std::integral_constant<uint32_t, 0> {};
+  template <class Q, class S, class... R> struct IndexOf<Q, S, R...>
+      : std::integral_constant<uint32_t, 1 + IndexOf<Q, R...>::value> {};
+};
+
+template <class... P>
+constexpr Port PortList<P...>::records[];
+
+template <class... P>
+template <class Q>
+constexpr uint32_t PortList<P...>::index() {
+  return IndexOf<Q, P...>::value;
+}
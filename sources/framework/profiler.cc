@@ -0,0 +1,66 @@
+#include "profiler.h"
+#if defined(ENABLE_PROFILER)
+#include <gperftools/profiler.h>
+#include <mutex>
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#if defined(_WIN32)
+# include <process.h>
+# define getpid _getpid
+#else
+# include <unistd.h>
+#endif
+
+static std::mutex profiler_mutex;
+static bool profiler_running = false;
+static unsigned profiler_serial = 0;
+
+Profiler::Profiler() {
+  const char *output = std::getenv("LV2_CPUPROFILE");
+  if (!output || !*output)
+    return;
+
+  std::lock_guard<std::mutex> lock(profiler_mutex);
+  unsigned serial = profiler_serial++;
+  if (profiler_running)
+    return;
+
+  std::string file = std::string(output) + ".fx." +
+      std::to_string(getpid()) + "." + std::to_string(serial);
+  if (!ProfilerStart(file.c_str())) {
+    std::cerr << "error starting the profiler: " << file << "\n";
+    return;
+  }
+
+  std::cerr << "profiling into: " << file << "\n";
+  profiler_running = true;
+  active_ = true;
+}
+
+Profiler::~Profiler() {
+  if (!active_)
+    return;
+
+  std::lock_guard<std::mutex> lock(profiler_mutex);
+  ProfilerStop();
+  profiler_running = false;
+}
+
+void Profiler::register_thread() {
+  if (!active_ || thread_registered_)
+    return;
+
+  ProfilerRegisterThread();
+  thread_registered_ = true;
+}
+#else
+Profiler::Profiler() {
+}
+
+Profiler::~Profiler() {
+}
+
+void Profiler::register_thread() {
+}
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+
+// CPU profiling of an effect instance, using gperftools
+//
+// It is active if the build has ENABLE_PROFILER, and the environment variable
+// LV2_CPUPROFILE names the output file. The profile covers the lifetime of the
+// object, and is written to "<LV2_CPUPROFILE>.fx.<pid>.<serial>".
+//
+// The sampling frequency, in Hz, is read by gperftools from the environment
+// variable CPUPROFILE_FREQUENCY when the library is loaded, so it can only be
+// set in the environment of the host.
+//
+// Since gperftools can run a single profile at a time, when several
+// instances coexist in a process, only the oldest is profiled.
+class Profiler {
+ public:
+  Profiler();
+  ~Profiler();
+
+  // register the calling thread for profiling, once
+  // for use in the processing thread, for timers which are per-thread
+  void register_thread();
+
+ private:
+  bool active_ = false;
+  bool thread_registered_ = false;
+  Profiler(const Profiler &) = delete;
+  Profiler &operator=(const Profiler &) = delete;
+};
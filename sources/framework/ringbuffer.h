@@ -0,0 +1,116 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+
+// Lock-free ring buffer of bytes, for a single producer and a single consumer
+//
+// The memory is allocated by the constructor. Reads and writes are
+// all-or-nothing, and never block.
+class RingBuffer {
+ public:
+  // the capacity is rounded up to a power of 2
+  explicit RingBuffer(size_t capacity);
+
+  size_t capacity() const { return mask_ + 1; }
+  size_t size_used() const;
+  size_t size_free() const;
+
+  // [producer]
+  bool write(const void *data, size_t size);
+  bool write2(const void *data1, size_t size1, const void *data2, size_t size2);
+
+  // [consumer]
+  bool peek(void *data, size_t size) const;
+  bool read(void *data, size_t size);
+  bool discard(size_t size);
+
+ private:
+  void copy_in(size_t pos, const void *data, size_t size);
+  void copy_out(size_t pos, void *data, size_t size) const;
+
+ private:
+  std::unique_ptr<uint8_t[]> data_;
+  size_t mask_ = 0;
+  std::atomic<size_t> rp_ {0};
+  std::atomic<size_t> wp_ {0};
+};
+
+//==============================================================================
+inline RingBuffer::RingBuffer(size_t capacity) {
+  size_t n = 1;
+  while (n < capacity)
+    n <<= 1;
+  data_.reset(new uint8_t[n]);
+  mask_ = n - 1;
+}
+
+inline size_t RingBuffer::size_used() const {
+  return wp_.load(std::memory_order_acquire) - rp_.load(std::memory_order_acquire);
+}
+
+inline size_t RingBuffer::size_free() const {
+  return capacity() - size_used();
+}
+
+inline bool RingBuffer::write(const void *data, size_t size) {
+  return write2(data, size, nullptr, 0);
+}
+
+inline bool RingBuffer::write2(const void *data1, size_t size1, const void *data2, size_t size2) {
+  size_t wp = wp_.load(std::memory_order_relaxed);
+  size_t rp = rp_.load(std::memory_order_acquire);
+  if (capacity() - (wp - rp) < size1 + size2)
+    return false;
+  copy_in(wp, data1, size1);
+  copy_in(wp + size1, data2, size2);
+  wp_.store(wp + size1 + size2, std::memory_order_release);
+  return true;
+}
+
+inline bool RingBuffer::peek(void *data, size_t size) const {
+  size_t rp = rp_.load(std::memory_order_relaxed);
+  size_t wp = wp_.load(std::memory_order_acquire);
+  if (wp - rp < size)
+    return false;
+  copy_out(rp, data, size);
+  return true;
+}
+
+inline bool RingBuffer::read(void *data, size_t size) {
+  if (!peek(data, size))
+    return false;
+  rp_.store(rp_.load(std::memory_order_relaxed) + size, std::memory_order_release);
+  return true;
+}
+
+inline bool RingBuffer::discard(size_t size) {
+  size_t rp = rp_.load(std::memory_order_relaxed);
+  size_t wp = wp_.load(std::memory_order_acquire);
+  if (wp - rp < size)
+    return false;
+  rp_.store(rp + size, std::memory_order_release);
+  return true;
+}
+
+inline void RingBuffer::copy_in(size_t pos, const void *data, size_t size) {
+  // data may be null when size is zero, which memcpy does not accept
+  if (size == 0)
+    return;
+  size_t i = pos & mask_;
+  size_t n = std::min(size, capacity() - i);
+  std::memcpy(&data_[i], data, n);
+  std::memcpy(&data_[0], static_cast<const uint8_t *>(data) + n, size - n);
+}
+
+inline void RingBuffer::copy_out(size_t pos, void *data, size_t size) const {
+  if (size == 0)
+    return;
+  size_t i = pos & mask_;
+  size_t n = std::min(size, capacity() - i);
+  std::memcpy(data, &data_[i], n);
+  std::memcpy(static_cast<uint8_t *>(data) + n, &data_[0], size - n);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "lv2all.h"
+#include <cstdint>
+
+// Processes a block of `nframes` frames, split at the timestamps of the
+// events in the sequence `seq`.
+//
+// `render(offset, count)` renders the frames in [offset, offset+count).
+// `process(event)` handles an event, at the frame where it is timestamped.
+//
+// In absence of events, `render` is called once over the entire block.
+// The timestamps are expected in frames, and in increasing order; those which
+// do not fit the block are clamped to its boundaries.
+template <class Render, class Process>
+void run_sequence(const LV2_Atom_Sequence *seq, unsigned nframes,
+                  Render &&render, Process &&process) {
+  unsigned offset = 0;
+
+  if (seq) {
+    LV2_ATOM_SEQUENCE_FOREACH(seq, event) {
+      int64_t time = event->time.frames;
+      unsigned frame = (time < offset) ? offset :
+          (time > nframes) ? nframes : unsigned(time);
+      if (frame > offset) {
+        render(offset, frame - offset);
+        offset = frame;
+      }
+      process(event);
+    }
+  }
+
+  if (offset < nframes)
+    render(offset, nframes - offset);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+// Process-wide read-only data, shared by reference counting
+//
+// The data of type T is constructed from the key as `T(key...)`, the first
+// time it is requested. Later requests with the same key, from any instance
+// of any plugin in the binary, return the same object while it is in use.
+// It is released when the last reference goes away.
+// Not realtime-safe: request the data when instantiating.
+template <class T, class... Key>
+std::shared_ptr<const T> shared_data(const Key &... key) {
+  static std::mutex mutex;
+  static std::map<std::tuple<Key...>, std::weak_ptr<const T>> registry;
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  for (auto it = registry.begin(); it != registry.end();) {
+    if (it->second.expired())
+      it = registry.erase(it);
+    else
+      ++it;
+  }
+
+  std::weak_ptr<const T> &entry = registry[std::make_tuple(key...)];
+  std::shared_ptr<const T> data = entry.lock();
+  if (!data) {
+    data = std::make_shared<const T>(key...);
+    entry = data;
+  }
+  return data;
+}
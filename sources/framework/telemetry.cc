@@ -0,0 +1,380 @@
+#include "telemetry.h"
+#include "kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+struct TelemetryURIDs {
+  explicit TelemetryURIDs(LV2_URID_Map *map);
+  LV2_URID levels;
+  LV2_URID scope;
+  LV2_URID levels_key;
+  LV2_URID voices_key;
+  LV2_URID notes_key;
+  LV2_URID offset_key;
+  LV2_URID data_key;
+  LV2_URID atom_object;
+  LV2_URID atom_int;
+  LV2_URID atom_long;
+  LV2_URID atom_float;
+  LV2_URID atom_vector;
+  LV2_URID event_transfer;
+};
+}  // namespace
+
+TelemetryURIDs::TelemetryURIDs(LV2_URID_Map *map) {
+  auto urid = [map](const char *uri) -> LV2_URID {
+    return map->map(map->handle, uri); };
+  levels = urid(telemetry_levels_uri);
+  scope = urid(telemetry_scope_uri);
+  levels_key = urid(telemetry_levels_key_uri);
+  voices_key = urid(telemetry_voices_key_uri);
+  notes_key = urid(telemetry_notes_key_uri);
+  offset_key = urid(telemetry_offset_key_uri);
+  data_key = urid(telemetry_data_key_uri);
+  atom_object = urid(LV2_ATOM__Object);
+  atom_int = urid(LV2_ATOM__Int);
+  atom_long = urid(LV2_ATOM__Long);
+  atom_float = urid(LV2_ATOM__Float);
+  atom_vector = urid(LV2_ATOM__Vector);
+  event_transfer = urid(LV2_ATOM__eventTransfer);
+}
+
+// sizes of the serialized messages, to check the capacity before writing
+static constexpr uint32_t pad_size(uint32_t size) {
+  return (size + 7) & ~7u;
+}
+static constexpr uint32_t int_property_size() {
+  return 2 * sizeof(uint32_t) + sizeof(LV2_Atom) + pad_size(sizeof(int32_t));
+}
+static constexpr uint32_t vector_property_size(uint32_t child_size, uint32_t count) {
+  return 2 * sizeof(uint32_t) + sizeof(LV2_Atom_Vector) + pad_size(child_size * count);
+}
+static constexpr uint32_t levels_message_size(unsigned channels) {
+  return sizeof(LV2_Atom_Event) + sizeof(LV2_Atom_Object_Body) +
+      int_property_size() +
+      vector_property_size(sizeof(int64_t), 2) +
+      vector_property_size(sizeof(float), 2 * channels);
+}
+static constexpr uint32_t scope_message_size(unsigned count) {
+  return sizeof(LV2_Atom_Event) + sizeof(LV2_Atom_Object_Body) +
+      int_property_size() +
+      vector_property_size(sizeof(float), count);
+}
+
+//==============================================================================
+struct TelemetryWriter::Impl {
+  Impl(LV2_URID_Map *map) : urid(map) {}
+
+  TelemetryURIDs urid;
+  LV2_Atom_Forge forge;
+  const Kernels *kernels = nullptr;
+  unsigned interval = 0;
+  unsigned decimation = 0;
+  unsigned scope_chunk = telemetry_scope_chunk_size;
+
+  // accumulation
+  unsigned frames = 0;
+  unsigned channels = 0;
+  float peak[telemetry_max_channels];
+  float sum_squares[telemetry_max_channels];
+  float scope[telemetry_scope_size];
+  unsigned scope_fill = 0;
+  unsigned scope_phase = 0;
+  float scope_point = 0;
+  unsigned voices = 0;
+  uint64_t notes[2] {};
+
+  // snapshot, waiting to be sent
+  bool levels_pending = false;
+  unsigned sent_channels = 0;
+  float sent_levels[2 * telemetry_max_channels];
+  unsigned sent_voices = 0;
+  uint64_t sent_notes[2] {};
+  float sent_scope[telemetry_scope_size];
+  unsigned scope_sent = telemetry_scope_size;
+
+  TelemetryChannel channel;
+
+  void snapshot();
+  void write_levels();
+  void write_scope_chunk(unsigned offset, unsigned count);
+};
+
+TelemetryWriter::TelemetryWriter(LV2_URID_Map *map, double rate, double update_rate)
+    : P(new Impl(map)) {
+  lv2_atom_forge_init(&P->forge, map);
+  P->kernels = &::kernels();
+  P->interval = std::max(1u, unsigned(std::lround(rate / update_rate)));
+  P->decimation = std::max(1u, P->interval / telemetry_scope_size);
+  reset();
+}
+
+TelemetryWriter::~TelemetryWriter() {
+}
+
+void TelemetryWriter::set_capacity(uint32_t sequence_size) {
+  // halve the chunks of the scope until one fits in an empty sequence
+  const uint32_t room = (sequence_size > sizeof(LV2_Atom_Sequence)) ?
+      (sequence_size - sizeof(LV2_Atom_Sequence)) : 0;
+  unsigned chunk = telemetry_scope_chunk_size;
+  while (chunk > 1 && scope_message_size(chunk) > room)
+    chunk /= 2;
+  P->scope_chunk = chunk;
+}
+
+void TelemetryWriter::reset() {
+  P->frames = 0;
+  P->channels = 0;
+  std::fill(P->peak, P->peak + telemetry_max_channels, 0.0f);
+  std::fill(P->sum_squares, P->sum_squares + telemetry_max_channels, 0.0f);
+  P->scope_fill = 0;
+  P->scope_phase = 0;
+  P->scope_point = 0;
+  P->levels_pending = false;
+  P->scope_sent = telemetry_scope_size;
+}
+
+void TelemetryWriter::analyze(const float *const *channels, unsigned nchannels, unsigned nframes) {
+  const Kernels &k = *P->kernels;
+  nchannels = std::min(nchannels, telemetry_max_channels);
+  P->channels = nchannels;
+
+  for (unsigned c = 0; c < nchannels; ++c) {
+    P->peak[c] = std::max(P->peak[c], k.peak(channels[c], nframes));
+    float rms = k.rms(channels[c], nframes);
+    P->sum_squares[c] += rms * rms * nframes;
+  }
+
+  if (nchannels > 0) {
+    // keep the sample of largest magnitude in each decimation interval
+    const float *in = channels[0];
+    const unsigned decimation = P->decimation;
+    unsigned fill = P->scope_fill;
+    unsigned phase = P->scope_phase;
+    float point = P->scope_point;
+    for (unsigned i = 0; i < nframes; ++i) {
+      float s = in[i];
+      point = (std::fabs(s) > std::fabs(point)) ? s : point;
+      if (++phase == decimation) {
+        if (fill < telemetry_scope_size)
+          P->scope[fill++] = point;
+        point = 0;
+        phase = 0;
+      }
+    }
+    P->scope_fill = fill;
+    P->scope_phase = phase;
+    P->scope_point = point;
+  }
+
+  P->frames += nframes;
+  if (P->frames >= P->interval)
+    P->snapshot();
+}
+
+void TelemetryWriter::set_voices(unsigned active, const uint64_t notes[2]) {
+  P->voices = active;
+  P->notes[0] = notes[0];
+  P->notes[1] = notes[1];
+}
+
+void TelemetryWriter::write(LV2_Atom_Sequence *seq) {
+  LV2_Atom_Forge &forge = P->forge;
+  lv2_atom_forge_set_buffer(&forge, reinterpret_cast<uint8_t *>(seq), seq->atom.size);
+
+  LV2_Atom_Forge_Frame frame;
+  if (!lv2_atom_forge_sequence_head(&forge, &frame, 0))
+    return;
+
+  auto room = [&forge]() -> uint32_t { return forge.size - forge.offset; };
+
+  if (P->levels_pending && room() >= levels_message_size(P->sent_channels)) {
+    P->write_levels();
+    P->levels_pending = false;
+  }
+
+  const unsigned chunk = P->scope_chunk;
+  while (P->scope_sent < telemetry_scope_size && room() >= scope_message_size(chunk)) {
+    unsigned count = std::min(chunk, telemetry_scope_size - P->scope_sent);
+    P->write_scope_chunk(P->scope_sent, count);
+    P->scope_sent += count;
+  }
+
+  lv2_atom_forge_pop(&forge, &frame);
+}
+
+TelemetryChannel &TelemetryWriter::channel() {
+  return P->channel;
+}
+
+void TelemetryWriter::Impl::snapshot() {
+  const unsigned nchannels = channels;
+  sent_channels = nchannels;
+  for (unsigned c = 0; c < nchannels; ++c) {
+    sent_levels[2 * c] = peak[c];
+    sent_levels[2 * c + 1] = std::sqrt(sum_squares[c] / frames);
+    peak[c] = 0;
+    sum_squares[c] = 0;
+  }
+  sent_voices = voices;
+  sent_notes[0] = notes[0];
+  sent_notes[1] = notes[1];
+  levels_pending = true;
+
+  std::copy(scope, scope + scope_fill, sent_scope);
+  std::fill(sent_scope + scope_fill, sent_scope + telemetry_scope_size, 0.0f);
+  scope_sent = 0;
+
+  TelemetryState &state = channel.back();
+  state.channels = nchannels;
+  for (unsigned c = 0; c < nchannels; ++c) {
+    state.peak[c] = sent_levels[2 * c];
+    state.rms[c] = sent_levels[2 * c + 1];
+  }
+  state.voices = sent_voices;
+  state.notes[0] = sent_notes[0];
+  state.notes[1] = sent_notes[1];
+  std::copy(sent_scope, sent_scope + telemetry_scope_size, state.scope);
+  channel.publish();
+
+  frames = 0;
+  scope_fill = 0;
+}
+
+void TelemetryWriter::Impl::write_levels() {
+  LV2_Atom_Forge_Frame frame;
+  lv2_atom_forge_frame_time(&forge, 0);
+  lv2_atom_forge_object(&forge, &frame, 0, urid.levels);
+  lv2_atom_forge_key(&forge, urid.voices_key);
+  lv2_atom_forge_int(&forge, int32_t(sent_voices));
+  lv2_atom_forge_key(&forge, urid.notes_key);
+  lv2_atom_forge_vector(&forge, sizeof(int64_t), urid.atom_long, 2, sent_notes);
+  lv2_atom_forge_key(&forge, urid.levels_key);
+  lv2_atom_forge_vector(&forge, sizeof(float), urid.atom_float, 2 * sent_channels, sent_levels);
+  lv2_atom_forge_pop(&forge, &frame);
+}
+
+void TelemetryWriter::Impl::write_scope_chunk(unsigned offset, unsigned count) {
+  LV2_Atom_Forge_Frame frame;
+  lv2_atom_forge_frame_time(&forge, 0);
+  lv2_atom_forge_object(&forge, &frame, 0, urid.scope);
+  lv2_atom_forge_key(&forge, urid.offset_key);
+  lv2_atom_forge_int(&forge, int32_t(offset));
+  lv2_atom_forge_key(&forge, urid.data_key);
+  lv2_atom_forge_vector(&forge, sizeof(float), urid.atom_float, count, &sent_scope[offset]);
+  lv2_atom_forge_pop(&forge, &frame);
+}
+
+//==============================================================================
+struct TelemetryReader::Impl {
+  Impl(LV2_URID_Map *map) : urid(map) {}
+
+  TelemetryURIDs urid;
+  TelemetryState state;
+  float scope[telemetry_scope_size] {};
+  unsigned scope_received = 0;
+
+  bool read_levels(const LV2_Atom_Object *obj);
+  bool read_scope(const LV2_Atom_Object *obj);
+  const LV2_Atom_Vector *as_vector(const LV2_Atom *atom, LV2_URID type, uint32_t size, uint32_t &count) const;
+};
+
+TelemetryReader::TelemetryReader(LV2_URID_Map *map)
+    : P(new Impl(map)) {
+}
+
+TelemetryReader::~TelemetryReader() {
+}
+
+bool TelemetryReader::read(uint32_t format, uint32_t size, const void *buffer) {
+  if (format != P->urid.event_transfer || size < sizeof(LV2_Atom_Object))
+    return false;
+
+  const LV2_Atom_Object *obj = reinterpret_cast<const LV2_Atom_Object *>(buffer);
+  if (obj->atom.type != P->urid.atom_object || lv2_atom_total_size(&obj->atom) > size)
+    return false;
+
+  if (obj->body.otype == P->urid.levels)
+    return P->read_levels(obj);
+  if (obj->body.otype == P->urid.scope)
+    return P->read_scope(obj);
+  return false;
+}
+
+const TelemetryState &TelemetryReader::state() const {
+  return P->state;
+}
+
+bool TelemetryReader::Impl::read_levels(const LV2_Atom_Object *obj) {
+  TelemetryState &state = this->state;
+  LV2_ATOM_OBJECT_FOREACH(obj, prop) {
+    const LV2_Atom *value = &prop->value;
+    uint32_t count;
+    if (prop->key == urid.voices_key && value->type == urid.atom_int) {
+      state.voices = reinterpret_cast<const LV2_Atom_Int *>(value)->body;
+    }
+    else if (prop->key == urid.notes_key) {
+      if (const LV2_Atom_Vector *vec = as_vector(value, urid.atom_long, sizeof(int64_t), count)) {
+        if (count == 2)
+          std::memcpy(state.notes, LV2_ATOM_CONTENTS(LV2_Atom_Vector, vec), sizeof(state.notes));
+      }
+    }
+    else if (prop->key == urid.levels_key) {
+      if (const LV2_Atom_Vector *vec = as_vector(value, urid.atom_float, sizeof(float), count)) {
+        const float *levels = reinterpret_cast<const float *>(LV2_ATOM_CONTENTS(LV2_Atom_Vector, vec));
+        unsigned nchannels = std::min(count / 2, telemetry_max_channels);
+        state.channels = nchannels;
+        for (unsigned c = 0; c < nchannels; ++c) {
+          state.peak[c] = levels[2 * c];
+          state.rms[c] = levels[2 * c + 1];
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool TelemetryReader::Impl::read_scope(const LV2_Atom_Object *obj) {
+  int32_t offset = -1;
+  const float *data = nullptr;
+  uint32_t count = 0;
+
+  LV2_ATOM_OBJECT_FOREACH(obj, prop) {
+    const LV2_Atom *value = &prop->value;
+    if (prop->key == urid.offset_key && value->type == urid.atom_int)
+      offset = reinterpret_cast<const LV2_Atom_Int *>(value)->body;
+    else if (prop->key == urid.data_key) {
+      if (const LV2_Atom_Vector *vec = as_vector(value, urid.atom_float, sizeof(float), count))
+        data = reinterpret_cast<const float *>(LV2_ATOM_CONTENTS(LV2_Atom_Vector, vec));
+    }
+  }
+
+  // accept the chunks in sequence, restarting on a new snapshot
+  if (!data || offset < 0 || unsigned(offset) != scope_received) {
+    scope_received = 0;
+    if (offset != 0 || !data)
+      return false;
+  }
+  count = std::min(count, telemetry_scope_size - offset);
+  std::copy(data, data + count, scope + offset);
+  scope_received = offset + count;
+
+  if (scope_received < telemetry_scope_size)
+    return false;
+  std::copy(scope, scope + telemetry_scope_size, state.scope);
+  scope_received = 0;
+  return true;
+}
+
+const LV2_Atom_Vector *TelemetryReader::Impl::as_vector(
+    const LV2_Atom *atom, LV2_URID type, uint32_t size, uint32_t &count) const {
+  if (atom->type != urid.atom_vector || atom->size < sizeof(LV2_Atom_Vector_Body))
+    return nullptr;
+  const LV2_Atom_Vector *vec = reinterpret_cast<const LV2_Atom_Vector *>(atom);
+  if (vec->body.child_type != type || vec->body.child_size != size)
+    return nullptr;
+  count = (atom->size - sizeof(LV2_Atom_Vector_Body)) / size;
+  return vec;
+}
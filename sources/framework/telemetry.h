@@ -0,0 +1,117 @@
+#pragma once
+#include "../meta/project.h"
+#include "lv2all.h"
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+// Telemetry stream, from the effect to the UI through an atom output port
+//
+// The effect accumulates the peak and RMS levels of its output, a decimated
+// waveform for a scope, and its voice activity. A snapshot of these is sent
+// at the rate of UI frames: the levels in one message, the scope in chunks
+// which are sent as the capacity of the output port permits.
+//
+// If the host grants the UI the instance-access and data-access features,
+// the UI reads the snapshots directly from a triple buffer of the effect,
+// and the atom messages are ignored.
+
+static constexpr char telemetry_levels_uri[] = PROJECT_URI "#TelemetryLevels";
+static constexpr char telemetry_scope_uri[] = PROJECT_URI "#TelemetryScope";
+static constexpr char telemetry_levels_key_uri[] = PROJECT_URI "#telemetryLevels";
+static constexpr char telemetry_voices_key_uri[] = PROJECT_URI "#telemetryVoices";
+static constexpr char telemetry_notes_key_uri[] = PROJECT_URI "#telemetryNotes";
+static constexpr char telemetry_offset_key_uri[] = PROJECT_URI "#telemetryOffset";
+static constexpr char telemetry_data_key_uri[] = PROJECT_URI "#telemetryData";
+static constexpr char telemetry_channel_uri[] = PROJECT_URI "#TelemetryChannel";
+
+static constexpr unsigned telemetry_max_channels = 8;
+static constexpr unsigned telemetry_scope_size = 512;
+static constexpr unsigned telemetry_scope_chunk_size = 128;
+
+//==============================================================================
+struct TelemetryState {
+  unsigned channels = 0;
+  float peak[telemetry_max_channels] {};
+  float rms[telemetry_max_channels] {};
+  unsigned voices = 0;
+  uint64_t notes[2] {};
+  float scope[telemetry_scope_size] {};
+};
+
+// Triple buffer of snapshots, between the audio thread and the UI thread
+class TelemetryChannel {
+ public:
+  // [realtime] the snapshot to fill, and its publication
+  TelemetryState &back() { return slots_[back_]; }
+  void publish() {
+    back_ = middle_.exchange(back_ | fresh_bit, std::memory_order_acq_rel) & index_mask;
+  }
+
+  // take the latest snapshot, and return whether it is a new one
+  bool fetch() {
+    if (!(middle_.load(std::memory_order_relaxed) & fresh_bit))
+      return false;
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & index_mask;
+    return true;
+  }
+  const TelemetryState &front() const { return slots_[front_]; }
+
+ private:
+  static constexpr unsigned index_mask = 3;
+  static constexpr unsigned fresh_bit = 4;
+  TelemetryState slots_[3];
+  unsigned back_ = 0;
+  std::atomic<unsigned> middle_ {1};
+  unsigned front_ = 2;
+};
+
+// extension data of the effect, at `telemetry_channel_uri`
+struct TelemetryChannelInterface {
+  TelemetryChannel *(*channel)(LV2_Handle instance);
+};
+
+//==============================================================================
+class TelemetryWriter {
+ public:
+  // `update_rate` is the number of snapshots per second
+  TelemetryWriter(LV2_URID_Map *map, double rate, double update_rate = 30);
+  ~TelemetryWriter();
+
+  // [non-realtime] discard the accumulated data
+  void reset();
+  // [non-realtime] fit the messages in sequences of `sequence_size` bytes,
+  // the size of the output port which the host guarantees
+  void set_capacity(uint32_t sequence_size);
+
+  // [realtime] accumulate the analysis of the output of a block
+  void analyze(const float *const *channels, unsigned nchannels, unsigned nframes);
+  // [realtime] set the count of active voices, and the bit set of playing notes
+  void set_voices(unsigned active, const uint64_t notes[2]);
+
+  // [realtime] write the pending messages, as far as the capacity permits
+  void write(LV2_Atom_Sequence *seq);
+
+  // the direct channel, which receives the same snapshots
+  TelemetryChannel &channel();
+
+ private:
+  struct Impl;
+  const std::unique_ptr<Impl> P;
+};
+
+//==============================================================================
+class TelemetryReader {
+ public:
+  explicit TelemetryReader(LV2_URID_Map *map);
+  ~TelemetryReader();
+
+  // decode a port event, and return whether it updated the state
+  bool read(uint32_t format, uint32_t size, const void *buffer);
+
+  const TelemetryState &state() const;
+
+ private:
+  struct Impl;
+  const std::unique_ptr<Impl> P;
+};
@@ -0,0 +1,356 @@
+#include "threadpool.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#include <system_error>
+#include <climits>
+#if defined(_WIN32)
+# include <windows.h>
+#elif defined(__APPLE__)
+# include <dispatch/dispatch.h>
+# include <pthread.h>
+#else
+# include <semaphore.h>
+# include <pthread.h>
+# include <cerrno>
+#endif
+
+class Semaphore {
+ public:
+  Semaphore();
+  ~Semaphore();
+  void post();
+  void wait();
+
+ private:
+#if defined(_WIN32)
+  HANDLE sem_;
+#elif defined(__APPLE__)
+  dispatch_semaphore_t sem_;
+#else
+  sem_t sem_;
+#endif
+  Semaphore(const Semaphore &) = delete;
+  Semaphore &operator=(const Semaphore &) = delete;
+};
+
+static inline void cpu_relax() {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  __builtin_ia32_pause();
+#endif
+}
+
+// the states of a task: a worker which finishes a task which the caller has
+// taken back finds it in the state `task_caller`, and discards its results
+enum TaskState : unsigned {
+  task_pending,
+  task_worker,
+  task_caller,
+  task_done,
+};
+
+struct Batch {
+  ThreadPool::Task *task = nullptr;
+  void *data = nullptr;
+  unsigned count = 0;
+  std::atomic<unsigned> next {0};
+  std::atomic<unsigned> state[ThreadPool::max_tasks];
+};
+
+// the scheduling of a thread, which the workers copy from the caller
+struct Priority {
+#if defined(_WIN32)
+  int priority = THREAD_PRIORITY_NORMAL;
+#else
+  int policy = SCHED_OTHER;
+  int priority = 0;
+#endif
+  static Priority current();
+  bool realtime() const;
+  bool apply() const;
+};
+
+struct ThreadPool::Impl {
+  std::vector<std::thread> threads;
+  Semaphore wakeup;
+  std::atomic<bool> quit {false};
+  std::atomic_flag busy = ATOMIC_FLAG_INIT;
+  std::atomic<Batch *> batch {nullptr};
+  std::atomic<unsigned> participants {0};
+  // the priority is written once by the first caller, before `has_priority`
+  Priority priority;
+  std::atomic<bool> has_priority {false};
+  Batch slot;
+  void work();
+  static void run_tasks(Batch &b, unsigned who);
+  static void run_task(Batch &b, unsigned index, unsigned who);
+};
+
+//==============================================================================
+ThreadPool::ThreadPool(unsigned num_workers)
+    : P(new Impl) {
+  try {
+    P->threads.reserve(num_workers);
+    for (unsigned i = 0; i < num_workers; ++i)
+      P->threads.emplace_back([this]() { P->work(); });
+  } catch (...) {
+    P->quit.store(true);
+    for (size_t i = 0, n = P->threads.size(); i < n; ++i)
+      P->wakeup.post();
+    for (std::thread &t : P->threads)
+      t.join();
+    throw;
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  P->quit.store(true);
+  for (size_t i = 0, n = P->threads.size(); i < n; ++i)
+    P->wakeup.post();
+  for (std::thread &t : P->threads)
+    t.join();
+}
+
+std::shared_ptr<ThreadPool> ThreadPool::shared() {
+  static std::mutex mutex;
+  static std::weak_ptr<ThreadPool> weak;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  std::shared_ptr<ThreadPool> pool = weak.lock();
+  if (!pool) {
+    unsigned num_cores = std::thread::hardware_concurrency();
+    pool.reset(new ThreadPool((num_cores > 1) ? (num_cores - 1) : 0));
+    weak = pool;
+  }
+  return pool;
+}
+
+unsigned ThreadPool::concurrency() const {
+  return P->threads.size() + 1;
+}
+
+void ThreadPool::wait_idle() {
+  while (P->participants.load() != 0)
+    std::this_thread::yield();
+}
+
+uint64_t ThreadPool::run(Task *task, Setup *setup, void *data, unsigned count, std::chrono::nanoseconds timeout) {
+  typedef std::chrono::steady_clock clock;
+  const clock::time_point deadline = clock::now() + timeout;
+
+  // take the pool, unless another thread is using it, or some late worker
+  // still references the previous batch
+  bool exclusive = !P->busy.test_and_set(std::memory_order_acquire);
+  if (exclusive && P->participants.load() != 0) {
+    P->busy.clear(std::memory_order_release);
+    exclusive = false;
+  }
+
+  if (!exclusive || count < 2 || count > max_tasks || P->threads.empty()) {
+    if (exclusive)
+      P->busy.clear(std::memory_order_release);
+    for (unsigned i = 0; i < count; ++i)
+      task(data, i, 1);
+    return (count < 64) ? ((uint64_t(1) << count) - 1) : ~uint64_t(0);
+  }
+
+  // the first caller gives its priority to the workers, a single time since
+  // querying it is a system call
+  if (!P->has_priority.load(std::memory_order_relaxed)) {
+    P->priority = Priority::current();
+    P->has_priority.store(true, std::memory_order_release);
+  }
+
+  // no worker reads the inputs of slot 0 until the batch is published
+  setup(data);
+
+  Batch &b = P->slot;
+  b.task = task;
+  b.data = data;
+  b.count = count;
+  b.next.store(0, std::memory_order_relaxed);
+  for (unsigned i = 0; i < count; ++i)
+    b.state[i].store(task_pending, std::memory_order_relaxed);
+  P->batch.store(&b);
+
+  unsigned num_wakeups = std::min<size_t>(P->threads.size(), count - 1);
+  for (unsigned i = 0; i < num_wakeups; ++i)
+    P->wakeup.post();
+
+  Impl::run_tasks(b, task_caller);
+
+  // also run the tasks which a worker has picked, but not claimed yet
+  for (unsigned i = 0; i < count; ++i)
+    Impl::run_task(b, i, task_caller);
+
+  // wait the tasks claimed by the workers, and take back the unfinished ones
+  // when the deadline is passed
+  for (bool waiting = true; waiting;) {
+    waiting = false;
+    const bool late = clock::now() >= deadline;
+    for (unsigned i = 0; i < count; ++i) {
+      if (b.state[i].load(std::memory_order_acquire) != task_worker)
+        continue;
+      unsigned expected = task_worker;
+      if (late && b.state[i].compare_exchange_strong(
+              expected, task_caller, std::memory_order_acq_rel))
+        task(data, i, 1);
+      else
+        waiting = waiting || expected == task_worker;
+    }
+    if (waiting)
+      cpu_relax();
+  }
+
+  uint64_t slots = 0;
+  for (unsigned i = 0; i < count; ++i) {
+    if (b.state[i].load(std::memory_order_relaxed) == task_caller)
+      slots |= uint64_t(1) << i;
+  }
+
+  P->batch.store(nullptr);
+  P->busy.clear(std::memory_order_release);
+  return slots;
+}
+
+//==============================================================================
+void ThreadPool::Impl::work() {
+  bool has_priority = false;
+
+  for (;;) {
+    wakeup.wait();
+    if (quit.load())
+      break;
+
+    // adopt the priority of the caller, once it is known
+    if (!has_priority && this->has_priority.load(std::memory_order_acquire)) {
+      if (priority.realtime())
+        priority.apply();
+      has_priority = true;
+    }
+
+    participants.fetch_add(1);
+    if (Batch *b = batch.load())
+      run_tasks(*b, task_worker);
+    participants.fetch_sub(1);
+  }
+}
+
+void ThreadPool::Impl::run_tasks(Batch &b, unsigned who) {
+  const unsigned count = b.count;
+  unsigned index;
+  while ((index = b.next.fetch_add(1, std::memory_order_relaxed)) < count)
+    run_task(b, index, who);
+}
+
+void ThreadPool::Impl::run_task(Batch &b, unsigned index, unsigned who) {
+  unsigned expected = task_pending;
+  if (!b.state[index].compare_exchange_strong(
+          expected, who, std::memory_order_acquire, std::memory_order_relaxed))
+    return;
+
+  if (who == task_caller)
+    b.task(b.data, index, 1);
+  else {
+    b.task(b.data, index, 0);
+    // publish the results, unless the caller has taken the task back
+    expected = task_worker;
+    b.state[index].compare_exchange_strong(
+        expected, task_done, std::memory_order_release, std::memory_order_relaxed);
+  }
+}
+
+//==============================================================================
+#if defined(_WIN32)
+Priority Priority::current() {
+  Priority p;
+  p.priority = GetThreadPriority(GetCurrentThread());
+  return p;
+}
+
+bool Priority::realtime() const {
+  return priority >= THREAD_PRIORITY_HIGHEST;
+}
+
+bool Priority::apply() const {
+  return SetThreadPriority(GetCurrentThread(), priority) != 0;
+}
+#else
+Priority Priority::current() {
+  Priority p;
+  sched_param param {};
+  if (pthread_getschedparam(pthread_self(), &p.policy, &param) == 0)
+    p.priority = param.sched_priority;
+  return p;
+}
+
+bool Priority::realtime() const {
+  return policy == SCHED_FIFO || policy == SCHED_RR;
+}
+
+bool Priority::apply() const {
+  // fails without the permission, such as RLIMIT_RTPRIO on Linux
+  sched_param param {};
+  param.sched_priority = priority;
+  return pthread_setschedparam(pthread_self(), policy, &param) == 0;
+}
+#endif
+
+//==============================================================================
+#if defined(_WIN32)
+Semaphore::Semaphore() {
+  sem_ = CreateSemaphoreA(nullptr, 0, LONG_MAX, nullptr);
+  if (!sem_)
+    throw std::system_error(GetLastError(), std::system_category());
+}
+
+Semaphore::~Semaphore() {
+  CloseHandle(sem_);
+}
+
+void Semaphore::post() {
+  ReleaseSemaphore(sem_, 1, nullptr);
+}
+
+void Semaphore::wait() {
+  WaitForSingleObject(sem_, INFINITE);
+}
+#elif defined(__APPLE__)
+Semaphore::Semaphore() {
+  sem_ = dispatch_semaphore_create(0);
+  if (!sem_)
+    throw std::runtime_error("cannot create a semaphore");
+}
+
+Semaphore::~Semaphore() {
+  dispatch_release(sem_);
+}
+
+void Semaphore::post() {
+  dispatch_semaphore_signal(sem_);
+}
+
+void Semaphore::wait() {
+  dispatch_semaphore_wait(sem_, DISPATCH_TIME_FOREVER);
+}
+#else
+Semaphore::Semaphore() {
+  if (sem_init(&sem_, 0, 0) != 0)
+    throw std::system_error(errno, std::generic_category());
+}
+
+Semaphore::~Semaphore() {
+  sem_destroy(&sem_);
+}
+
+void Semaphore::post() {
+  sem_post(&sem_);
+}
+
+void Semaphore::wait() {
+  while (sem_wait(&sem_) != 0 && errno == EINTR);
+}
+#endif
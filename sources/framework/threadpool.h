@@ -0,0 +1,68 @@
+#pragma once
+#include <chrono>
+#include <memory>
+#include <cstdint>
+
+// Pool of threads to split the processing of a block across processor cores
+//
+// A pool is run by one thread at a time, which takes part in the work: the
+// tasks are claimed one by one, by the caller and by whichever worker is
+// available. A task which no worker has claimed yet when the caller is free
+// is run by the caller itself. The tasks which the workers have claimed are
+// awaited until a timeout; past it, the caller takes back the unfinished ones
+// and runs them itself, so a late or preempted worker never delays the block
+// by more than the timeout; in the worst case, it is processed as if
+// single-threaded.
+// If the pool is busy, the tasks all run in the calling thread. The pool is
+// shared by the instances of a process, and one of them at a time gives tasks
+// to the workers, while the others run theirs serially: this is a deliberate
+// simplification over work stealing, which would have each caller run the
+// tasks of the others.
+//
+// A task has two slots of inputs and results: slot 0 when it runs in a
+// worker, and slot 1 when it runs in the caller. The slot of a task taken
+// back keeps the results of its worker, which are discarded, and the worker
+// may still read the inputs and write the results after `run` has returned:
+// until it is back in the pool, the pool is busy, so slot 0 is not used
+// again. Hence the inputs of slot 0 are written by `setup`, which `run` calls
+// only once the workers are idle; and before freeing the data of the tasks,
+// the caller waits for the late workers with `wait_idle`.
+//
+// The workers adopt the realtime priority of the first thread which runs the
+// pool, if the system permits it.
+//
+// The running of tasks does not allocate, nor lock a mutex.
+class ThreadPool {
+ public:
+  explicit ThreadPool(unsigned num_workers);
+  ~ThreadPool();
+
+  // get the pool shared by the whole process, creating it if necessary
+  // not for use in realtime context
+  static std::shared_ptr<ThreadPool> shared();
+
+  // the number of threads which can run in parallel, caller included
+  unsigned concurrency() const;
+
+  // the maximum number of tasks of a run
+  static constexpr unsigned max_tasks = 64;
+
+  typedef void (Task)(void *data, unsigned index, unsigned slot);
+  typedef void (Setup)(void *data);
+
+  // run tasks with indices [0, count), and return when all are finished,
+  // taking back the tasks of the workers `timeout` after the start
+  // `setup` is called first if the tasks go to the workers, to write the
+  // inputs of slot 0
+  // the result has the bit `index` set for the tasks whose results are in
+  // slot 1, and clear for those in slot 0
+  uint64_t run(Task *task, Setup *setup, void *data, unsigned count, std::chrono::nanoseconds timeout);
+
+  // wait until no worker runs a task, including the ones taken back
+  // not for use in realtime context
+  void wait_idle();
+
+ private:
+  struct Impl;
+  const std::unique_ptr<Impl> P;
+};
@@ -0,0 +1,221 @@
+#include "turtle.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+
+static unsigned utf8_sequence_length(const unsigned char *p, size_t avail);
+static void write_uchar(std::string &out, unsigned c);
+static void write_percent(std::string &out, unsigned char c);
+
+//==============================================================================
+TurtleWriter::TurtleWriter(std::string &out)
+    : out_(out) {
+}
+
+void TurtleWriter::prefix(const char *name, boost::string_view uri) {
+  out_.append("@prefix ");
+  out_.append(name);
+  out_.append(": ");
+  write_uri(out_, uri);
+  out_.append(" .\n");
+}
+
+//==============================================================================
+void TurtleWriter::subject(boost::string_view uri) {
+  assert(depth_ == 0);
+  out_.push_back('\n');
+  write_uri(out_, uri);
+  has_predicate_[0] = false;
+  has_object_ = false;
+}
+
+void TurtleWriter::end_subject() {
+  assert(depth_ == 0);
+  out_.append(" .\n");
+}
+
+void TurtleWriter::predicate(const char *name) {
+  if (has_predicate_[depth_])
+    out_.append(" ;");
+  out_.push_back('\n');
+  out_.append(2 * (depth_ + 1), ' ');
+  out_.append(name);
+  has_predicate_[depth_] = true;
+  has_object_ = false;
+}
+
+void TurtleWriter::begin_object() {
+  assert(has_predicate_[depth_]);
+  out_.append(has_object_ ? ", " : " ");
+  has_object_ = true;
+}
+
+void TurtleWriter::object_uri(boost::string_view uri) {
+  begin_object();
+  write_uri(out_, uri);
+}
+
+void TurtleWriter::object_name(const char *name) {
+  begin_object();
+  out_.append(name);
+}
+
+void TurtleWriter::object_string(boost::string_view text) {
+  begin_object();
+  write_string(out_, text);
+}
+
+void TurtleWriter::object_integer(long value) {
+  begin_object();
+  char buf[32];
+  int n = std::snprintf(buf, sizeof(buf), "%ld", value);
+  out_.append(buf, n);
+}
+
+void TurtleWriter::object_number(float value) {
+  begin_object();
+  write_number(out_, value);
+}
+
+void TurtleWriter::begin_blank() {
+  begin_object();
+  out_.push_back('[');
+  assert(depth_ + 1 < max_depth);
+  has_predicate_[++depth_] = false;
+}
+
+void TurtleWriter::end_blank() {
+  assert(depth_ > 0);
+  if (has_predicate_[depth_])
+    out_.append(" ;");
+  --depth_;
+  out_.push_back('\n');
+  out_.append(2 * (depth_ + 1), ' ');
+  out_.push_back(']');
+  has_object_ = true;
+}
+
+//==============================================================================
+void TurtleWriter::write_uri(std::string &out, boost::string_view uri) {
+  const unsigned char *p = (const unsigned char *)uri.data();
+  const unsigned char *end = p + uri.size();
+
+  // the characters which an IRI excludes are percent-encoded, since Turtle
+  // does not accept them escaped either
+  out.push_back('<');
+  while (p < end) {
+    const unsigned char c = *p;
+    if (c < 0x80) {
+      switch (c) {
+        case '<': case '>': case '"': case '{': case '}':
+        case '|': case '^': case '`': case '\\':
+          write_percent(out, c);
+          break;
+        default:
+          if (c <= 0x20 || c == 0x7f)
+            write_percent(out, c);
+          else
+            out.push_back(c);
+          break;
+      }
+      ++p;
+    }
+    else if (unsigned n = utf8_sequence_length(p, end - p)) {
+      out.append((const char *)p, n);
+      p += n;
+    }
+    else {
+      out.append("\xef\xbf\xbd");
+      ++p;
+    }
+  }
+  out.push_back('>');
+}
+
+void TurtleWriter::write_string(std::string &out, boost::string_view text) {
+  const unsigned char *p = (const unsigned char *)text.data();
+  const unsigned char *end = p + text.size();
+
+  out.push_back('"');
+  while (p < end) {
+    const unsigned char c = *p;
+    if (c < 0x80) {
+      switch (c) {
+        case '\t': out.append("\\t"); break;
+        case '\n': out.append("\\n"); break;
+        case '\r': out.append("\\r"); break;
+        case '\b': out.append("\\b"); break;
+        case '\f': out.append("\\f"); break;
+        case '"': out.append("\\\""); break;
+        case '\\': out.append("\\\\"); break;
+        default:
+          if (c < 0x20 || c == 0x7f)
+            write_uchar(out, c);
+          else
+            out.push_back(c);
+          break;
+      }
+      ++p;
+    }
+    else if (unsigned n = utf8_sequence_length(p, end - p)) {
+      out.append((const char *)p, n);
+      p += n;
+    }
+    else {
+      out.append("\xef\xbf\xbd");
+      ++p;
+    }
+  }
+  out.push_back('"');
+}
+
+void TurtleWriter::write_number(std::string &out, float value) {
+  // shortest representation which reads back as the same value
+  char buf[64];
+  int n = 0;
+  for (int precision = 6; precision <= 9; ++precision) {
+    n = std::snprintf(buf, sizeof(buf), "%.*g", precision, value);
+    if (std::strtof(buf, nullptr) == value)
+      break;
+  }
+  // independent of the decimal separator of the C locale
+  for (int i = 0; i < n; ++i)
+    if (buf[i] == ',') buf[i] = '.';
+  out.append(buf, n);
+}
+
+//==============================================================================
+static unsigned utf8_sequence_length(const unsigned char *p, size_t avail) {
+  const unsigned char c = p[0];
+  unsigned n;
+  unsigned min;
+  if (c >= 0xc2 && c <= 0xdf) { n = 2; min = 0x80; }
+  else if (c >= 0xe0 && c <= 0xef) { n = 3; min = 0x800; }
+  else if (c >= 0xf0 && c <= 0xf4) { n = 4; min = 0x10000; }
+  else return 0;
+
+  if (avail < n)
+    return 0;
+
+  unsigned cp = c & (0x7f >> n);
+  for (unsigned i = 1; i < n; ++i) {
+    if ((p[i] & 0xc0) != 0x80)
+      return 0;
+    cp = (cp << 6) | (p[i] & 0x3f);
+  }
+  if (cp < min || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff))
+    return 0;
+  return n;
+}
+
+static void write_uchar(std::string &out, unsigned c) {
+  char buf[16];
+  int n = std::snprintf(buf, sizeof(buf), "\\u%04X", c);
+  out.append(buf, n);
+}
+
+static void write_percent(std::string &out, unsigned char c) {
+  char buf[4];
+  int n = std::snprintf(buf, sizeof(buf), "%%%02X", c);
+  out.append(buf, n);
+}
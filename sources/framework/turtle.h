@@ -0,0 +1,50 @@
+#pragma once
+#include <boost/utility/string_view.hpp>
+#include <string>
+
+// Single-pass Turtle serializer, which appends to a buffer.
+//
+// Statements are written in sequence: a subject, then predicates, each
+// followed by objects. Separators are emitted when the next element
+// arrives, so nothing written needs to be patched afterwards.
+class TurtleWriter {
+ public:
+  explicit TurtleWriter(std::string &out);
+
+  std::string &buffer() const { return out_; }
+
+  //============================================================================
+  void prefix(const char *name, boost::string_view uri);
+
+  //============================================================================
+  void subject(boost::string_view uri);
+  void end_subject();
+
+  // a prefixed name, or the keyword "a"
+  void predicate(const char *name);
+
+  void object_uri(boost::string_view uri);
+  void object_name(const char *name);
+  void object_string(boost::string_view text);
+  void object_integer(long value);
+  void object_number(float value);
+
+  // a blank node in object position, which receives predicates until closed
+  void begin_blank();
+  void end_blank();
+
+  //============================================================================
+  static void write_uri(std::string &out, boost::string_view uri);
+  static void write_string(std::string &out, boost::string_view text);
+  static void write_number(std::string &out, float value);
+
+ private:
+  void begin_object();
+
+ private:
+  static constexpr unsigned max_depth = 16;
+  std::string &out_;
+  unsigned depth_ = 0;
+  bool has_predicate_[max_depth] {};
+  bool has_object_ = false;
+};
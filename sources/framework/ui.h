@@ -3,18 +3,23 @@
 #include <boost/utility/string_view.hpp>
 #include <memory>
 #include <cstdint>
+class TelemetryChannel;
 
 class UI {
  public:
+  // `telemetry` is the direct channel from the effect, or null if unavailable
+  // `resize` is the feature of the host, or null if unavailable
   UI(void *parent, LV2_URID_Map *map, LV2_URID_Unmap *unmap,
-     const char *bundle_path);
+     const char *bundle_path, TelemetryChannel *telemetry, LV2UI_Resize *resize);
   ~UI();
 
+  // set an option, at the instantiation or later by the options interface
   void option(const LV2_Options_Option &o);
 
   LV2UI_Widget widget() const;
-  static unsigned width();
-  static unsigned height();
+  // the size in pixels, which depends on the scale factor
+  unsigned width() const;
+  unsigned height() const;
 
   void port_event(
       uint32_t port_index, uint32_t buffer_size, uint32_t format, const void *buffer);
@@ -0,0 +1,16 @@
+#pragma once
+
+// A list of the variants of the effect, each exported as a plugin of its own
+template <class... V> struct VariantList {};
+
+// A constant table with one entry per variant, in the order of the list
+// The entry of the variant V is `F::template make<V>()`.
+template <class T, class List, class F> struct VariantTable;
+
+template <class T, class... V, class F>
+struct VariantTable<T, VariantList<V...>, F> {
+  static constexpr T data[] = { F::template make<V>()... };
+};
+
+template <class T, class... V, class F>
+constexpr T VariantTable<T, VariantList<V...>, F>::data[];
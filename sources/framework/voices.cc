@@ -0,0 +1,410 @@
+#include "voices.h"
+#include "shared.h"
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+typedef uint16_t voice_t;
+static constexpr voice_t no_voice = voice_t(-1);
+static constexpr unsigned num_notes = 128;
+
+// the voices are rendered in groups of this many lanes, one per voice
+static constexpr unsigned lanes = 8;
+
+// phase increments of the notes, shared by the pools at the same rate
+struct PitchTable {
+  explicit PitchTable(double rate);
+  float increment[num_notes];
+};
+
+struct VoicePool::Impl {
+  explicit Impl(unsigned capacity);
+
+  unsigned capacity = 0;
+  unsigned num_groups = 0;
+  unsigned active = 0;
+  float rate = 0;
+  float attack_rate = 0;
+  float release_rate = 0;
+  float cutoff_coef = 0;
+
+  // voice state, structure-of-arrays, padded to a whole number of groups
+  std::unique_ptr<float[]> phase;
+  std::unique_ptr<float[]> increment;
+  std::unique_ptr<float[]> gain;
+  std::unique_ptr<float[]> level;
+  std::unique_ptr<float[]> slope;
+  std::unique_ptr<float[]> filter;
+  std::unique_ptr<uint8_t[]> note;
+  std::unique_ptr<uint8_t[]> playing;
+
+  // copy of the state which the parts in slot 0 read, since a worker which
+  // is late may still read it when the live state has changed
+  struct Snapshot {
+    explicit Snapshot(unsigned size);
+    std::unique_ptr<float[]> phase;
+    std::unique_ptr<float[]> increment;
+    std::unique_ptr<float[]> gain;
+    std::unique_ptr<float[]> level;
+    std::unique_ptr<float[]> slope;
+    std::unique_ptr<float[]> filter;
+    std::unique_ptr<uint8_t[]> playing;
+    float cutoff_coef = 0;
+  };
+  Snapshot snapshot;
+
+  // the state which a part reads, depending on its slot
+  struct Input {
+    const float *phase;
+    const float *increment;
+    const float *gain;
+    const float *level;
+    const float *slope;
+    const float *filter;
+    const uint8_t *playing;
+    float cutoff_coef;
+  };
+  Input input(unsigned slot) const;
+
+  // new state of the rendered voices, in two slots until `collect`
+  struct Result {
+    explicit Result(unsigned size);
+    std::unique_ptr<float[]> phase;
+    std::unique_ptr<float[]> level;
+    std::unique_ptr<float[]> filter;
+    std::unique_ptr<uint8_t[]> finished;
+  };
+  Result result[2];
+
+  // active voices in order of age, oldest first
+  std::unique_ptr<voice_t[]> prev;
+  std::unique_ptr<voice_t[]> next;
+  voice_t oldest = no_voice;
+  voice_t newest = no_voice;
+
+  // stack of free voices
+  std::unique_ptr<voice_t[]> free;
+  unsigned num_free = 0;
+
+  voice_t note_voice[num_notes];
+  std::shared_ptr<const PitchTable> pitch;
+
+  voice_t allocate();
+  void release(voice_t v);
+  void link(voice_t v);
+  void unlink(voice_t v);
+  template <class T> void render_group(const Input &in, unsigned group, T *out, unsigned nframes, unsigned slot);
+};
+
+VoicePool::Impl::Impl(unsigned capacity)
+    : capacity(capacity),
+      num_groups((capacity + lanes - 1) / lanes),
+      phase(new float[num_groups * lanes]()),
+      increment(new float[num_groups * lanes]()),
+      gain(new float[num_groups * lanes]()),
+      level(new float[num_groups * lanes]()),
+      slope(new float[num_groups * lanes]()),
+      filter(new float[num_groups * lanes]()),
+      note(new uint8_t[capacity]()),
+      playing(new uint8_t[num_groups * lanes]()),
+      snapshot(num_groups * lanes),
+      result{Result(num_groups * lanes), Result(num_groups * lanes)},
+      prev(new voice_t[capacity]),
+      next(new voice_t[capacity]),
+      free(new voice_t[capacity]) {
+}
+
+VoicePool::Impl::Snapshot::Snapshot(unsigned size)
+    : phase(new float[size]()),
+      increment(new float[size]()),
+      gain(new float[size]()),
+      level(new float[size]()),
+      slope(new float[size]()),
+      filter(new float[size]()),
+      playing(new uint8_t[size]()) {
+}
+
+VoicePool::Impl::Result::Result(unsigned size)
+    : phase(new float[size]()),
+      level(new float[size]()),
+      filter(new float[size]()),
+      finished(new uint8_t[size]()) {
+}
+
+PitchTable::PitchTable(double rate) {
+  for (unsigned n = 0; n < num_notes; ++n) {
+    double frequency = 440.0 * std::exp2((int(n) - 69) / 12.0);
+    increment[n] = std::min(0.5, frequency / rate);
+  }
+}
+
+//==============================================================================
+VoicePool::VoicePool(unsigned capacity, double rate)
+    : P(new Impl(capacity)) {
+  assert(capacity > 0 && capacity < no_voice);
+
+  P->rate = rate;
+  P->pitch = shared_data<PitchTable>(rate);
+  all_sounds_off();
+
+  set_attack(0.005f);
+  set_release(0.2f);
+  set_cutoff(5000.0f);
+}
+
+VoicePool::~VoicePool() {
+}
+
+//==============================================================================
+unsigned VoicePool::capacity() const {
+  return P->capacity;
+}
+
+unsigned VoicePool::active() const {
+  return P->active;
+}
+
+void VoicePool::held_notes(uint64_t bits[2]) const {
+  bits[0] = bits[1] = 0;
+  for (unsigned note = 0; note < num_notes; ++note) {
+    if (P->note_voice[note] != no_voice)
+      bits[note / 64] |= uint64_t(1) << (note % 64);
+  }
+}
+
+//==============================================================================
+void VoicePool::note_on(unsigned note, unsigned velocity) {
+  if (note >= num_notes)
+    return;
+  if (velocity == 0)
+    return note_off(note);
+
+  voice_t v = P->note_voice[note];
+  if (v == no_voice) {
+    v = P->allocate();
+    P->phase[v] = 0;
+    P->level[v] = 0;
+    P->filter[v] = 0;
+    P->note[v] = note;
+    P->note_voice[note] = v;
+  }
+  else {
+    // retrigger: move to the newest position
+    P->unlink(v);
+    P->link(v);
+  }
+
+  P->increment[v] = P->pitch->increment[note];
+  P->gain[v] = velocity * (1.0f / 127);
+  P->slope[v] = P->attack_rate;
+}
+
+void VoicePool::note_off(unsigned note) {
+  if (note >= num_notes)
+    return;
+
+  voice_t v = P->note_voice[note];
+  if (v == no_voice)
+    return;
+
+  P->slope[v] = -P->release_rate;
+  P->note_voice[note] = no_voice;
+}
+
+void VoicePool::all_notes_off() {
+  for (unsigned n = 0; n < num_notes; ++n)
+    note_off(n);
+}
+
+void VoicePool::all_sounds_off() {
+  P->active = 0;
+  P->oldest = no_voice;
+  P->newest = no_voice;
+  P->num_free = P->capacity;
+  for (unsigned i = 0; i < P->capacity; ++i)
+    P->free[i] = voice_t(P->capacity - 1 - i);
+  std::fill_n(P->playing.get(), P->num_groups * lanes, 0);
+  std::fill_n(P->note_voice, num_notes, no_voice);
+}
+
+//==============================================================================
+void VoicePool::set_attack(float attack) {
+  P->attack_rate = 1 / std::max(1.0f, attack * P->rate);
+}
+
+void VoicePool::set_release(float release) {
+  P->release_rate = 1 / std::max(1.0f, release * P->rate);
+}
+
+void VoicePool::set_cutoff(float cutoff) {
+  cutoff = std::min(cutoff, 0.49f * P->rate);
+  P->cutoff_coef = 1 - std::exp(-2 * float(M_PI) * cutoff / P->rate);
+}
+
+//==============================================================================
+template <class T>
+void VoicePool::render(T *out, unsigned nframes) {
+  // in slot 1, which reads the live state
+  render_part(out, nframes, 0, 1, 1);
+  collect(1, 1);
+}
+
+template <class T>
+void VoicePool::render_part(T *out, unsigned nframes, unsigned part, unsigned num_parts, unsigned slot) {
+  // each part is a contiguous range of groups
+  const unsigned num_groups = P->num_groups;
+  const unsigned begin = part * num_groups / num_parts;
+  const unsigned end = (part + 1) * num_groups / num_parts;
+  const Impl::Input in = P->input(slot);
+  for (unsigned g = begin; g < end; ++g) {
+    const uint8_t *group_playing = &in.playing[g * lanes];
+    if (std::any_of(group_playing, group_playing + lanes, [](uint8_t x) { return x != 0; }))
+      P->render_group(in, g, out, nframes, slot);
+  }
+}
+
+template void VoicePool::render<float>(float *, unsigned);
+template void VoicePool::render<double>(double *, unsigned);
+template void VoicePool::render_part<float>(float *, unsigned, unsigned, unsigned, unsigned);
+template void VoicePool::render_part<double>(double *, unsigned, unsigned, unsigned, unsigned);
+
+void VoicePool::snapshot() {
+  const unsigned size = P->num_groups * lanes;
+  Impl::Snapshot &snap = P->snapshot;
+  std::copy_n(P->phase.get(), size, snap.phase.get());
+  std::copy_n(P->increment.get(), size, snap.increment.get());
+  std::copy_n(P->gain.get(), size, snap.gain.get());
+  std::copy_n(P->level.get(), size, snap.level.get());
+  std::copy_n(P->slope.get(), size, snap.slope.get());
+  std::copy_n(P->filter.get(), size, snap.filter.get());
+  std::copy_n(P->playing.get(), size, snap.playing.get());
+  snap.cutoff_coef = P->cutoff_coef;
+}
+
+void VoicePool::collect(unsigned num_parts, uint64_t slots) {
+  const unsigned num_groups = P->num_groups;
+  const uint8_t *playing = P->playing.get();
+  for (unsigned part = 0; part < num_parts; ++part) {
+    Impl::Result &result = P->result[(slots >> part) & 1];
+    const unsigned begin = part * num_groups / num_parts * lanes;
+    const unsigned end = std::min(P->capacity, (part + 1) * num_groups / num_parts * lanes);
+    // the results are only read, a late worker may still write slot 0
+    for (unsigned v = begin; v < end; ++v) {
+      if (!playing[v])
+        continue;
+      P->phase[v] = result.phase[v];
+      P->level[v] = result.level[v];
+      P->filter[v] = result.filter[v];
+      if (result.finished[v])
+        P->release(v);
+    }
+  }
+}
+
+//==============================================================================
+auto VoicePool::Impl::input(unsigned slot) const -> Input {
+  if (slot == 0) {
+    const Snapshot &snap = this->snapshot;
+    return Input{snap.phase.get(), snap.increment.get(), snap.gain.get(),
+                 snap.level.get(), snap.slope.get(), snap.filter.get(),
+                 snap.playing.get(), snap.cutoff_coef};
+  }
+  return Input{this->phase.get(), this->increment.get(), this->gain.get(),
+               this->level.get(), this->slope.get(), this->filter.get(),
+               this->playing.get(), this->cutoff_coef};
+}
+
+voice_t VoicePool::Impl::allocate() {
+  voice_t v;
+  if (num_free > 0)
+    v = free[--num_free];
+  else {
+    // steal the oldest
+    v = oldest;
+    unlink(v);
+    if (note_voice[note[v]] == v)
+      note_voice[note[v]] = no_voice;
+  }
+  link(v);
+  return v;
+}
+
+void VoicePool::Impl::release(voice_t v) {
+  unlink(v);
+  if (note_voice[note[v]] == v)
+    note_voice[note[v]] = no_voice;
+  free[num_free++] = v;
+}
+
+void VoicePool::Impl::link(voice_t v) {
+  prev[v] = newest;
+  next[v] = no_voice;
+  if (newest != no_voice)
+    next[newest] = v;
+  else
+    oldest = v;
+  newest = v;
+  playing[v] = 1;
+  ++active;
+}
+
+void VoicePool::Impl::unlink(voice_t v) {
+  voice_t p = prev[v], n = next[v];
+  if (p != no_voice)
+    next[p] = n;
+  else
+    oldest = n;
+  if (n != no_voice)
+    prev[n] = p;
+  else
+    newest = p;
+  playing[v] = 0;
+  --active;
+}
+
+template <class T>
+void VoicePool::Impl::render_group(const Input &in, unsigned group, T *out, unsigned nframes, unsigned slot) {
+  static_assert(lanes == 8, "the sum of the lanes expects 8 lanes");
+
+  // load the state of the group into lanes, the voices which do not play
+  // are silent
+  const unsigned first = group * lanes;
+  float phase[lanes], increment[lanes], amp[lanes];
+  float level[lanes], slope[lanes], filter[lanes];
+  for (unsigned j = 0; j < lanes; ++j) {
+    const unsigned v = first + j;
+    const bool on = in.playing[v];
+    phase[j] = in.phase[v];
+    increment[j] = in.increment[v];
+    amp[j] = on ? in.gain[v] : 0.0f;
+    level[j] = in.level[v];
+    slope[j] = in.slope[v];
+    filter[j] = on ? in.filter[v] : 0.0f;
+  }
+
+  // the samples are the outer loop, each step processes all the lanes at
+  // once, which vectorizes the filter across voices despite its recurrence
+  const float coef = in.cutoff_coef;
+  for (unsigned i = 0; i < nframes; ++i) {
+    float y[lanes];
+    for (unsigned j = 0; j < lanes; ++j) {
+      float x = (2 * phase[j] - 1) * (level[j] * amp[j]);
+      filter[j] += coef * (x - filter[j]);
+      y[j] = filter[j];
+      float p = phase[j] + increment[j];
+      phase[j] = p - int(p);
+      level[j] = std::max(0.0f, std::min(1.0f, level[j] + slope[j]));
+    }
+    out[i] += ((y[0] + y[1]) + (y[2] + y[3])) + ((y[4] + y[5]) + (y[6] + y[7]));
+  }
+
+  // the state of the voices is kept apart until `collect`
+  Result &result = this->result[slot];
+  for (unsigned j = 0; j < lanes; ++j) {
+    const unsigned v = first + j;
+    result.phase[v] = phase[j];
+    result.level[v] = level[j];
+    result.filter[v] = filter[j];
+    result.finished[v] = level[j] == 0 && slope[j] < 0;
+  }
+}
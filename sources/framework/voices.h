@@ -0,0 +1,58 @@
+#pragma once
+#include <memory>
+#include <cstdint>
+
+// Fixed-capacity pool of synthesizer voices
+//
+// The voice state is stored as structure-of-arrays. The voices are rendered
+// in groups of 8 lanes: the samples are the outer loop, and every step
+// updates the oscillators, envelopes and filters of the group together, which
+// the compiler turns into vector instructions.
+// All memory is allocated by the constructor, and no other member function
+// allocates.
+// Note-on and note-off are constant time; when the pool is full, the note-on
+// steals the oldest voice.
+class VoicePool {
+ public:
+  VoicePool(unsigned capacity, double rate);
+  ~VoicePool();
+
+  //============================================================================
+  unsigned capacity() const;
+  unsigned active() const;
+  // the bit set of the held notes, one bit per MIDI note
+  void held_notes(uint64_t bits[2]) const;
+
+  //============================================================================
+  void note_on(unsigned note, unsigned velocity);
+  void note_off(unsigned note);
+  void all_notes_off();
+  void all_sounds_off();
+
+  //============================================================================
+  // times in seconds, frequency in Hz
+  void set_attack(float attack);
+  void set_release(float release);
+  void set_cutoff(float cutoff);
+
+  //============================================================================
+  // mix the active voices into `out`, in single or double precision
+  template <class T> void render(T *out, unsigned nframes);
+
+  // mix one of `num_parts` subsets of the active voices into `out`, each a
+  // contiguous range of groups
+  // the parts can be rendered in parallel, then `collect` ends the block.
+  // the new state of the voices is kept in `slot`, 0 or 1, and the bits of
+  // `slots` tell `collect` the slot from which to take each part; a part can
+  // thus be rendered twice, and one result discarded.
+  // slot 1 reads the live state, and slot 0 the copy made by `snapshot`, so
+  // that a part of slot 0 can finish late while the live state changes.
+  template <class T> void render_part(T *out, unsigned nframes, unsigned part, unsigned num_parts, unsigned slot);
+  void collect(unsigned num_parts, uint64_t slots);
+  // copy the live state for the parts of slot 0, when none is rendering
+  void snapshot();
+
+ private:
+  struct Impl;
+  const std::unique_ptr<Impl> P;
+};
@@ -0,0 +1,113 @@
+#include "worker.h"
+
+struct WorkMessage {
+  uint32_t type;
+  uint32_t size;
+};
+
+// the token passed through the host; the messages are in the queues
+// note: the receiver processes all pending messages when it gets a token, so
+//       a message whose notification fails goes with the next one.
+typedef uint32_t WorkToken;
+
+struct Worker::Impl {
+  explicit Impl(size_t capacity);
+  const LV2_Worker_Schedule *schedule = nullptr;
+  LV2_Worker_Respond_Function respond = nullptr;
+  LV2_Worker_Respond_Handle respond_handle = nullptr;
+  RingBuffer jobs;
+  RingBuffer responses;
+  std::unique_ptr<uint8_t[]> job_buffer;
+  std::unique_ptr<uint8_t[]> response_buffer;
+  static bool push(RingBuffer &queue, uint32_t type, const void *data, uint32_t size);
+  static bool pop(RingBuffer &queue, uint8_t *buffer, WorkMessage &msg);
+};
+
+Worker::Impl::Impl(size_t capacity)
+    : jobs(capacity),
+      responses(capacity),
+      job_buffer(new uint8_t[jobs.capacity()]),
+      response_buffer(new uint8_t[responses.capacity()]) {
+}
+
+//==============================================================================
+Worker::Worker(size_t capacity)
+    : P(new Impl(capacity)) {
+}
+
+Worker::~Worker() {
+}
+
+void Worker::set_schedule(const LV2_Worker_Schedule *schedule) {
+  P->schedule = schedule;
+}
+
+bool Worker::available() const {
+  return P->schedule != nullptr;
+}
+
+//==============================================================================
+bool Worker::schedule_work(uint32_t type, const void *data, uint32_t size) {
+  const LV2_Worker_Schedule *schedule = P->schedule;
+  if (!schedule)
+    return false;
+
+  if (!Impl::push(P->jobs, type, data, size))
+    return false;
+
+  WorkToken token = 0;
+  return schedule->schedule_work(schedule->handle, sizeof(token), &token) == LV2_WORKER_SUCCESS;
+}
+
+bool Worker::respond(uint32_t type, const void *data, uint32_t size) {
+  LV2_Worker_Respond_Function respond = P->respond;
+  if (!respond)
+    return false;
+
+  if (!Impl::push(P->responses, type, data, size))
+    return false;
+
+  WorkToken token = 0;
+  return respond(P->respond_handle, sizeof(token), &token) == LV2_WORKER_SUCCESS;
+}
+
+//==============================================================================
+LV2_Worker_Status Worker::work(
+    LV2_Worker_Respond_Function respond, LV2_Worker_Respond_Handle handle,
+    Handler *handler, void *handler_data) {
+  WorkMessage msg;
+  uint8_t *buffer = P->job_buffer.get();
+
+  P->respond = respond;
+  P->respond_handle = handle;
+  while (Impl::pop(P->jobs, buffer, msg))
+    handler(handler_data, msg.type, buffer, msg.size);
+  P->respond = nullptr;
+  P->respond_handle = nullptr;
+  return LV2_WORKER_SUCCESS;
+}
+
+LV2_Worker_Status Worker::work_response(Handler *handler, void *handler_data) {
+  WorkMessage msg;
+  uint8_t *buffer = P->response_buffer.get();
+
+  while (Impl::pop(P->responses, buffer, msg))
+    handler(handler_data, msg.type, buffer, msg.size);
+  return LV2_WORKER_SUCCESS;
+}
+
+//==============================================================================
+bool Worker::Impl::push(RingBuffer &queue, uint32_t type, const void *data, uint32_t size) {
+  WorkMessage msg;
+  msg.type = type;
+  msg.size = size;
+  return queue.write2(&msg, sizeof(msg), data, size);
+}
+
+bool Worker::Impl::pop(RingBuffer &queue, uint8_t *buffer, WorkMessage &msg) {
+  if (!queue.peek(&msg, sizeof(msg)))
+    return false;
+  if (!queue.discard(sizeof(msg)))
+    return false;
+  return queue.read(buffer, msg.size);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "ringbuffer.h"
+#include "lv2all.h"
+#include <type_traits>
+#include <memory>
+#include <cstdint>
+
+// Non-realtime job processing through the LV2 worker extension
+//
+// Jobs and responses are typed messages, which are passed through
+// preallocated lock-free queues. The host's worker mechanism only carries the
+// notification that a message is pending.
+class Worker {
+ public:
+  explicit Worker(size_t capacity = 8192);
+  ~Worker();
+
+  // set the host's scheduler, or null if the host does not provide one
+  void set_schedule(const LV2_Worker_Schedule *schedule);
+  bool available() const;
+
+  //============================================================================
+  // [realtime thread] schedule a job for the worker thread
+  bool schedule_work(uint32_t type, const void *data, uint32_t size);
+  template <class T> bool schedule_work(uint32_t type, const T &data);
+
+  // [worker thread] send back a response for the realtime thread
+  bool respond(uint32_t type, const void *data, uint32_t size);
+  template <class T> bool respond(uint32_t type, const T &data);
+
+  //============================================================================
+  typedef void (Handler)(void *, uint32_t type, const void *data, uint32_t size);
+
+  // [worker thread] process a job, in response to a host's `work` call
+  LV2_Worker_Status work(
+      LV2_Worker_Respond_Function respond, LV2_Worker_Respond_Handle handle,
+      Handler *handler, void *handler_data);
+  // [realtime thread] process a response, in response to a host's `work_response` call
+  LV2_Worker_Status work_response(Handler *handler, void *handler_data);
+
+ private:
+  struct Impl;
+  const std::unique_ptr<Impl> P;
+};
+
+//==============================================================================
+template <class T> bool Worker::schedule_work(uint32_t type, const T &data) {
+  static_assert(std::is_trivially_copyable<T>::value, "the message must be trivially copyable");
+  return schedule_work(type, &data, sizeof(T));
+}
+
+template <class T> bool Worker::respond(uint32_t type, const T &data) {
+  static_assert(std::is_trivially_copyable<T>::value, "the message must be trivially copyable");
+  return respond(type, &data, sizeof(T));
+}
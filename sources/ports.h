@@ -0,0 +1,94 @@
+#pragma once
+#include "framework/ports.h"
+#include <array>
+#include <utility>
+
+//==============================================================================
+// the ports of the effect
+namespace EffectPort {
+
+static constexpr const char *midi_event_types[] = {
+  LV2_MIDI__MidiEvent,
+};
+static constexpr const char *optional_properties[] = {
+  LV2_CORE__connectionOptional,
+};
+
+static constexpr unsigned max_audio_outputs = 8;
+static constexpr const char *audio_output_symbols[max_audio_outputs] = {
+  "audio_output_1", "audio_output_2", "audio_output_3", "audio_output_4",
+  "audio_output_5", "audio_output_6", "audio_output_7", "audio_output_8",
+};
+static constexpr const char *audio_output_names[max_audio_outputs] = {
+  "Audio output 1", "Audio output 2", "Audio output 3", "Audio output 4",
+  "Audio output 5", "Audio output 6", "Audio output 7", "Audio output 8",
+};
+
+template <unsigned I>
+struct AudioOutput {
+  static_assert(I < max_audio_outputs, "too many audio outputs");
+  static constexpr Port record() {
+    return audio_port(PortDirection::Output, audio_output_symbols[I], audio_output_names[I]);
+  }
+};
+
+struct EventInput {
+  static constexpr Port record() {
+    return event_port(PortDirection::Input, "event_input", "Event input",
+                      LV2_ATOM__Sequence, midi_event_types);
+  }
+};
+
+struct EventOutput {
+  static constexpr Port record() {
+    return event_port(PortDirection::Output, "event_output", "Event output",
+                      LV2_ATOM__Sequence, {})
+        .with_properties(optional_properties);
+  }
+};
+
+struct DspLoad {
+  static constexpr Port record() {
+    return control_port(PortDirection::Output, "dsp_load", "DSP load", 0, 0, 100)
+        .with_properties(optional_properties);
+  }
+};
+
+struct DspLoadPeak {
+  static constexpr Port record() {
+    return control_port(PortDirection::Output, "dsp_load_peak", "DSP load peak", 0, 0, 100)
+        .with_properties(optional_properties);
+  }
+};
+
+struct DspLoadP99 {
+  static constexpr Port record() {
+    return control_port(PortDirection::Output, "dsp_load_p99", "DSP load 99th percentile", 0, 0, 100)
+        .with_properties(optional_properties);
+  }
+};
+
+}  // namespace EffectPort
+
+//==============================================================================
+template <class Outputs> struct EffectPortLayout;
+
+template <unsigned... I>
+struct EffectPortLayout<std::integer_sequence<unsigned, I...>> {
+  typedef PortList<
+    EffectPort::AudioOutput<I>...,
+    EffectPort::EventInput,
+    EffectPort::EventOutput,
+    EffectPort::DspLoad,
+    EffectPort::DspLoadPeak,
+    EffectPort::DspLoadP99> type;
+
+  // the buffers of the audio outputs, in order
+  static std::array<float *, sizeof...(I)> audio_outputs(const typename type::Ports &ports) {
+    return {{ ports.template get<EffectPort::AudioOutput<I>>()... }};
+  }
+};
+
+// the ports of the effect with the given number of channels
+template <unsigned Channels>
+using EffectPorts = typename EffectPortLayout<std::make_integer_sequence<unsigned, Channels>>::type;
@@ -1,48 +1,65 @@
 #include "framework/ui.h"
+#include "framework/idle.h"
+#include "framework/nvgbackend.h"
+#include "canvas.h"
 #include "meta/project.h"
 #include <GL/glew.h>
 #include <pugl/gl.h>
 #include <pugl/pugl.h>
-#include <nanovg.h>
-#include <nanovg_gl.h>
 #include <boost/scope_exit.hpp>
 #include <stdexcept>
 #include <iostream>
-#include <cmath>
 
 struct UI::Impl {
-  static constexpr unsigned width = 600;
-  static constexpr unsigned height = 400;
   PuglView *view {};
   PuglNativeWindow parent = 0;
   PuglNativeWindow widget = 0;
-  NVGcontext *vg {};
+  LV2UI_Resize *resize {};
+  std::unique_ptr<Canvas> canvas;
+  IdleScheduler scheduler;
   bool exposed = false;
   bool initialized_nvg = false;
-  bool needs_redraw = true;
+  bool drawable = false;
+  struct {
+    LV2_URID atom_float;
+    LV2_URID scale_factor;
+  } urid;
   void create_widget();
+  void set_scale_factor(float scale);
   void handle_event(const PuglEvent *event);
   void init_nvg();
-  void draw_nvg();
   void update();
   static void print_gl_info(std::ostream &os);
 };
 
 //==============================================================================
 UI::UI(void *parent, LV2_URID_Map *map, LV2_URID_Unmap *unmap,
-       const char *bundle_path)
+       const char *bundle_path, TelemetryChannel *telemetry, LV2UI_Resize *resize)
     : P(new Impl) {
   P->parent = PuglNativeWindow(parent);
+  P->resize = resize;
+  P->canvas.reset(new Canvas(map, telemetry));
+  P->urid.atom_float = map->map(map->handle, LV2_ATOM__Float);
+  P->urid.scale_factor = map->map(map->handle, LV2_UI__scaleFactor);
 }
 
 UI::~UI() {
-  if (P->vg)
-    nvgDeleteGL2(P->vg);
+  if (P->drawable) {
+    puglEnterContext(P->view);
+    P->canvas->cleanup();
+    puglLeaveContext(P->view, false);
+  }
   if (P->view)
     puglDestroy(P->view);
 }
 
 void UI::option(const LV2_Options_Option &option) {
+  const auto urid = P->urid;
+
+  if (option.key == urid.scale_factor) {
+    if (option.type == urid.atom_float && option.size == sizeof(float))
+      P->set_scale_factor(*reinterpret_cast<const float *>(option.value));
+  }
 }
 
 LV2UI_Widget UI::widget() const {
@@ -51,16 +68,18 @@ LV2UI_Widget UI::widget() const {
   return LV2UI_Widget(P->widget);
 }
 
-unsigned UI::width() {
-  return Impl::width;
+unsigned UI::width() const {
+  return P->canvas->pixel_width();
 }
 
-unsigned UI::height() {
-  return Impl::height;
+unsigned UI::height() const {
+  return P->canvas->pixel_height();
 }
 
 void UI::port_event(
     uint32_t port_index, uint32_t buffer_size, uint32_t format, const void *buffer) {
+  if (P->canvas->port_event(port_index, buffer_size, format, buffer))
+    P->update();
 }
 
 bool UI::needs_idle_callback() {
@@ -72,26 +91,30 @@ bool UI::idle() {
   if (!view)
     return false;
 
-  puglProcessEvents(view);
+  IdleScheduler &scheduler = P->scheduler;
+  if (scheduler.events_pending())
+    puglProcessEvents(view);
   if (!P->exposed)
     return false;
 
+  if (P->canvas->fetch())
+    P->update();
+
   if (!P->initialized_nvg) {
     puglEnterContext(view);
     P->init_nvg();
+    scheduler.attach_current_display();
     P->initialized_nvg = true;
     puglLeaveContext(view, false);
   }
 
-  NVGcontext *vg = P->vg;
-  if (!vg)
+  if (!P->drawable)
     return false;
 
-  if (P->needs_redraw) {
+  if (scheduler.should_redraw()) {
     puglEnterContext(view);
-    P->draw_nvg();
+    P->canvas->draw();
     puglLeaveContext(view, true);
-    P->needs_redraw = false;
   }
   return true;
 }
@@ -118,7 +141,7 @@ void UI::Impl::create_widget() {
     reinterpret_cast<UI::Impl *>(puglGetHandle(view))->handle_event(event); });
 
   puglInitWindowParent(view, this->parent);
-  puglInitWindowSize(view, Impl::width, Impl::height);
+  puglInitWindowSize(view, this->canvas->pixel_width(), this->canvas->pixel_height());
   puglInitResizable(view, false);
   puglInitContextType(view, PUGL_GL);
 
@@ -135,15 +158,29 @@ void UI::Impl::create_widget() {
 
 void UI::Impl::handle_event(const PuglEvent *event) {
   switch (event->type) {
-    case PUGL_EXPOSE: this->exposed = true; this->needs_redraw = true; break;
+    case PUGL_EXPOSE: this->exposed = true; update(); break;
     case PUGL_CLOSE: this->exposed = false; break;
     // handle other events here, invoke update() to make the screen redraw
     default: break;
   }
 }
 
-#include "../resources/Roboto-Regular.ttf.c"
-#include "../resources/Roboto-Bold.ttf.c"
+void UI::Impl::set_scale_factor(float scale) {
+  Canvas &canvas = *this->canvas;
+  if (!(scale > 0) || scale == canvas.pixel_ratio())
+    return;
+
+  // the canvas draws at the new resolution from the next frame, and its
+  // cached layers are painted again once
+  canvas.set_pixel_ratio(scale);
+
+  // if the window exists, ask the host to resize it
+  if (this->view) {
+    if (this->resize)
+      this->resize->ui_resize(this->resize->handle, canvas.pixel_width(), canvas.pixel_height());
+    update();
+  }
+}
 
 void UI::Impl::init_nvg() {
   if (glewInit() != GLEW_OK) {
@@ -151,104 +188,17 @@ void UI::Impl::init_nvg() {
     return;
   }
 
-  NVGcontext *vg = this->vg = nvgCreateGL2(NVG_ANTIALIAS|NVG_STENCIL_STROKES);
-  if (!vg) {
-    std::cerr << "error creating a NanoVG context\n";
+  const NvgBackend &nvg = nvg_backend();
+  if (!this->canvas->init(nvg))
     return;
-  }
+  this->drawable = true;
 
   Impl::print_gl_info(std::cerr);
-
-  nvgCreateFontMem(
-      vg, "sans",
-      const_cast<unsigned char *>(Roboto_Regular_ttf), sizeof(Roboto_Regular_ttf),
-      false);
-  nvgCreateFontMem(
-      vg, "sans-bold",
-      const_cast<unsigned char *>(Roboto_Bold_ttf), sizeof(Roboto_Bold_ttf),
-      false);
-}
-
-void UI::Impl::draw_nvg() {
-  glViewport(0, 0, Impl::width, Impl::height);
-  glClearColor(0, 0, 0, 0);
-  glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT|GL_STENCIL_BUFFER_BIT);
-
-  NVGcontext *vg = this->vg;
-  nvgBeginFrame(vg, Impl::width, Impl::height, 1);
-
-  // text drawing example
-  {
-    nvgSave(vg);
-
-    float w = 400, h = 100;
-    float x = (Impl::width - w) / 2, y = 50;
-
-    nvgStrokeColor(vg, nvgRGB(200, 200, 200));
-    nvgFillColor(vg, nvgRGB(100, 100, 100));
-    nvgStrokeWidth(vg, 10);
-
-    nvgBeginPath(vg);
-    nvgRoundedRect(vg, x, y, w, h, 20);
-    nvgFill(vg);
-    nvgStroke(vg);
-
-    nvgFillColor(vg, nvgRGB(200, 200, 200));
-
-    nvgFontSize(vg, 64);
-    nvgFontFace(vg, "sans-bold");
-    nvgTextAlign(vg, NVG_ALIGN_CENTER|NVG_ALIGN_MIDDLE);
-    nvgTextBox(vg, x, y + h / 2, w, "Hello, LV2!", nullptr);
-
-    nvgRestore(vg);
-  }
-
-  // plot drawing example
-  {
-    nvgSave(vg);
-
-    constexpr float pi = M_PI;
-
-    float w = Impl::width * 0.9f, h = 150;
-    float x = (Impl::width - w) / 2, y = 200;
-
-    constexpr unsigned nsamples = 64;
-    float samples[nsamples];
-    float sx[nsamples], sy[nsamples];
-    float dx = w / (nsamples - 1);
-
-    for (unsigned i = 0; i < nsamples; ++i) {
-      float x = 4 * ((2 * i / float(nsamples - 1)) - 1);
-      samples[i] = (x == 0) ? 1 : (std::sin(pi * x) / (pi * x));
-    }
-
-    for (unsigned i = 0; i < nsamples; ++i) {
-      float v = (samples[i] + 0.25f) / 1.25f;
-      sx[i] = x + i * dx;
-      sy[i] = y + h * (1 - v);
-    }
-
-    nvgBeginPath(vg);
-    nvgRect(vg, x - 8, y - 8, w + 16, h + 16);
-    nvgFillColor(vg, nvgRGB(50, 50, 50));
-    nvgFill(vg);
-
-    nvgBeginPath(vg);
-    nvgMoveTo(vg, sx[0], sy[0]);
-    for (unsigned i = 1; i < nsamples; i++)
-      nvgQuadTo(vg, (sx[i] + sx[i-1]) / 2, (sy[i] + sy[i-1]) / 2, sx[i], sy[i]);
-    nvgStrokeColor(vg, nvgRGB(255, 200, 0));
-    nvgStrokeWidth(vg, 3.0f);
-    nvgStroke(vg);
-
-    nvgRestore(vg);
-  }
-
-  nvgEndFrame(vg);
+  std::cerr << "NanoVG backend: " << nvg.name << "\n";
 }
 
 void UI::Impl::update() {
-  this->needs_redraw = true;
+  this->scheduler.request_redraw();
 }
 
 void UI::Impl::print_gl_info(std::ostream &os) {
@@ -0,0 +1,61 @@
+#pragma once
+#include "framework/variants.h"
+#include "ports.h"
+
+//==============================================================================
+// a configuration of the effect, which is exported as a plugin of its own
+template <unsigned Channels, class Sample, unsigned MaxVoices>
+struct EffectVariant {
+  // number of audio outputs
+  static constexpr unsigned channels = Channels;
+  // precision of the internal mix
+  typedef Sample sample_type;
+  // size of the voice pool
+  static constexpr unsigned max_voices = MaxVoices;
+  // layout of the ports
+  typedef EffectPortLayout<std::make_integer_sequence<unsigned, Channels>> port_layout;
+  typedef EffectPorts<Channels> ports;
+};
+
+namespace EffectVariants {
+
+struct Stereo : EffectVariant<2, float, 128> {
+  static constexpr const char *uri() { return effect_uri; }
+  static constexpr const char *name() { return PROJECT_DISPLAY_NAME; }
+};
+
+struct StereoLite : EffectVariant<2, float, 32> {
+  static constexpr const char *uri() { return PROJECT_URI "#lite"; }
+  static constexpr const char *name() { return PROJECT_DISPLAY_NAME " (lite)"; }
+};
+
+struct StereoDouble : EffectVariant<2, double, 128> {
+  static constexpr const char *uri() { return PROJECT_URI "#double"; }
+  static constexpr const char *name() { return PROJECT_DISPLAY_NAME " (double precision)"; }
+};
+
+struct Mono : EffectVariant<1, float, 128> {
+  static constexpr const char *uri() { return PROJECT_URI "#mono"; }
+  static constexpr const char *name() { return PROJECT_DISPLAY_NAME " (mono)"; }
+};
+
+struct Surround51 : EffectVariant<6, float, 128> {
+  static constexpr const char *uri() { return PROJECT_URI "#surround51"; }
+  static constexpr const char *name() { return PROJECT_DISPLAY_NAME " (5.1)"; }
+};
+
+struct Surround71 : EffectVariant<8, float, 128> {
+  static constexpr const char *uri() { return PROJECT_URI "#surround71"; }
+  static constexpr const char *name() { return PROJECT_DISPLAY_NAME " (7.1)"; }
+};
+
+}  // namespace EffectVariants
+
+// the plugins of the binary, in the order of the descriptor indices
+typedef VariantList<
+  EffectVariants::Stereo,
+  EffectVariants::StereoLite,
+  EffectVariants::StereoDouble,
+  EffectVariants::Mono,
+  EffectVariants::Surround51,
+  EffectVariants::Surround71> EffectVariantList;
@@ -0,0 +1,403 @@
+#include "framework/description.h"
+#include "framework/turtle.h"
+#include <serd/serd.h>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#if defined(_WIN32)
+# include <windows.h>
+#else
+# include <dlfcn.h>
+# include <unistd.h>
+#endif
+
+// Checks the Turtle of the writer and of the manifest with a real parser
+//
+// The first part writes literals and URIs which need escaping, and verifies
+// that the parser reads back the same text. The second part writes the
+// manifest of the effect binary given as argument, in both layouts, and
+// verifies that every file parses and describes the effects.
+
+static unsigned failures = 0;
+
+static void check(bool condition, const std::string &what) {
+  if (!condition) {
+    std::cerr << "FAIL: " << what << "\n";
+    ++failures;
+  }
+}
+
+//==============================================================================
+struct Statement {
+  std::string subject;
+  std::string predicate;
+  std::string object;
+  SerdType object_type;
+};
+
+// a Turtle document parsed by serd, with the prefixed names expanded
+struct Document {
+  SerdEnv *env = nullptr;
+  std::vector<Statement> statements;
+  std::vector<std::string> errors;
+  unsigned num_reads = 0;
+
+  Document();
+  ~Document();
+  bool read_string(const std::string &text);
+  bool read_file(const std::string &path);
+  const Statement *find(const std::string &subject, const std::string &predicate) const;
+  bool has(const std::string &subject, const std::string &predicate, const std::string &object) const;
+
+ private:
+  bool read(const std::string *text, const std::string *path);
+  std::string expand(const SerdNode *node) const;
+  Document(const Document &) = delete;
+  Document &operator=(const Document &) = delete;
+};
+
+Document::Document()
+    : env(serd_env_new(nullptr)) {
+}
+
+Document::~Document() {
+  serd_env_free(env);
+}
+
+bool Document::read_string(const std::string &text) {
+  return read(&text, nullptr);
+}
+
+bool Document::read_file(const std::string &path) {
+  return read(nullptr, &path);
+}
+
+bool Document::read(const std::string *text, const std::string *path) {
+  SerdReader *reader = serd_reader_new(
+      SERD_TURTLE, this, nullptr,
+      [](void *handle, const SerdNode *uri) -> SerdStatus {
+        Document &doc = *reinterpret_cast<Document *>(handle);
+        return serd_env_set_base_uri(doc.env, uri);
+      },
+      [](void *handle, const SerdNode *name, const SerdNode *uri) -> SerdStatus {
+        Document &doc = *reinterpret_cast<Document *>(handle);
+        return serd_env_set_prefix(doc.env, name, uri);
+      },
+      [](void *handle, SerdStatementFlags, const SerdNode *,
+         const SerdNode *subject, const SerdNode *predicate, const SerdNode *object,
+         const SerdNode *, const SerdNode *) -> SerdStatus {
+        Document &doc = *reinterpret_cast<Document *>(handle);
+        doc.statements.push_back(Statement {
+            doc.expand(subject), doc.expand(predicate), doc.expand(object), object->type});
+        return SERD_SUCCESS;
+      },
+      nullptr);
+
+  // the blank nodes of each read are distinct
+  std::string blank_prefix = "r" + std::to_string(num_reads++) + "_";
+  serd_reader_add_blank_prefix(reader, (const uint8_t *)blank_prefix.c_str());
+
+  // invalid text is an error, not a warning
+  serd_reader_set_strict(reader, true);
+  serd_reader_set_error_sink(reader, [](void *handle, const SerdError *error) -> SerdStatus {
+    Document &doc = *reinterpret_cast<Document *>(handle);
+    char message[1024];
+    std::vsnprintf(message, sizeof(message), error->fmt, *error->args);
+    // most messages of serd end with a newline, but not all of them
+    std::string msg = message;
+    if (!msg.empty() && msg.back() == '\n')
+      msg.pop_back();
+    doc.errors.push_back(std::to_string(error->line) + ":" +
+                         std::to_string(error->col) + ": " + msg);
+    return SERD_SUCCESS;
+  }, this);
+
+  size_t num_errors = errors.size();
+  SerdStatus status;
+  if (text)
+    status = serd_reader_read_string(reader, (const uint8_t *)text->c_str());
+  else
+    status = serd_reader_read_file(reader, (const uint8_t *)path->c_str());
+  serd_reader_free(reader);
+
+  return status == SERD_SUCCESS && errors.size() == num_errors;
+}
+
+std::string Document::expand(const SerdNode *node) const {
+  if (node->type == SERD_CURIE) {
+    SerdNode uri = serd_env_expand_node(env, node);
+    if (!uri.buf)
+      return std::string();
+    std::string result((const char *)uri.buf, uri.n_bytes);
+    serd_node_free(&uri);
+    return result;
+  }
+  return std::string((const char *)node->buf, node->n_bytes);
+}
+
+const Statement *Document::find(const std::string &subject, const std::string &predicate) const {
+  for (const Statement &st : statements) {
+    if (st.subject == subject && st.predicate == predicate)
+      return &st;
+  }
+  return nullptr;
+}
+
+bool Document::has(const std::string &subject, const std::string &predicate, const std::string &object) const {
+  for (const Statement &st : statements) {
+    if (st.subject == subject && st.predicate == predicate && st.object == object)
+      return true;
+  }
+  return false;
+}
+
+static void print_errors(const Document &doc, const std::string &name) {
+  for (const std::string &error : doc.errors)
+    std::cerr << name << ":" << error << "\n";
+}
+
+//==============================================================================
+static void test_escaping() {
+  static const char subject[] = "urn:test:subject";
+  static const char fffd[] = "\xef\xbf\xbd";
+
+  struct Case {
+    const char *name;
+    std::string input;
+    std::string expected;
+  };
+
+  const Case literals[] = {
+    {"plain text", "Hello, LV2!", "Hello, LV2!"},
+    {"empty text", "", ""},
+    {"quotes and backslashes", "say \"a\\b\"", "say \"a\\b\""},
+    {"whitespace escapes", "a\tb\nc\rd", "a\tb\nc\rd"},
+    {"control characters", std::string("\x01\x08\x0c\x1f\x7f", 5), std::string("\x01\x08\x0c\x1f\x7f", 5)},
+    {"latin text", "Caf\xc3\xa9 cr\xc3\xa8me", "Caf\xc3\xa9 cr\xc3\xa8me"},
+    {"CJK text", "\xe9\x9f\xb3\xe6\xa5\xbd", "\xe9\x9f\xb3\xe6\xa5\xbd"},
+    {"astral plane", "\xf0\x9f\x8e\xb9 keys", "\xf0\x9f\x8e\xb9 keys"},
+    {"invalid byte", "a\xff" "b", std::string("a") + fffd + "b"},
+    {"stray continuation", "\x80x", std::string(fffd) + "x"},
+    {"overlong encoding", "\xc0\xaf", std::string(fffd) + fffd},
+    {"truncated sequence", "x\xe6\x97", std::string("x") + fffd + fffd},
+    {"surrogate", "\xed\xa0\x80", std::string(fffd) + fffd + fffd},
+    {"beyond U+10FFFF", "\xf4\x90\x80\x80", std::string(fffd) + fffd + fffd + fffd},
+  };
+
+  const Case uris[] = {
+    {"plain URI", "http://example.com/a#b", "http://example.com/a#b"},
+    {"excluded characters", "urn:a b<c>\"{|}^`\\", "urn:a%20b%3Cc%3E%22%7B%7C%7D%5E%60%5C"},
+    {"non-ASCII URI", "urn:caf\xc3\xa9", "urn:caf\xc3\xa9"},
+    {"invalid URI", "urn:\xff", std::string("urn:") + fffd},
+  };
+
+  const float numbers[] = {0, 1, -0.5f, 0.1f, 440, 1e-7f, 1e8f, 3.4e38f};
+
+  std::string text;
+  TurtleWriter ttl(text);
+  ttl.subject(subject);
+  ttl.predicate("<urn:test:literal>");
+  for (const Case &c : literals)
+    ttl.object_string(c.input);
+  ttl.predicate("<urn:test:uri>");
+  for (const Case &c : uris)
+    ttl.object_uri(c.input);
+  ttl.predicate("<urn:test:number>");
+  for (float value : numbers)
+    ttl.object_number(value);
+  ttl.end_subject();
+
+  Document doc;
+  bool ok = doc.read_string(text);
+  check(ok, "parsing the escaped text");
+  if (!ok) {
+    print_errors(doc, "escaping");
+    std::cerr << text << "\n";
+    return;
+  }
+
+  std::vector<const Statement *> values[3];
+  for (const Statement &st : doc.statements) {
+    if (st.predicate == "urn:test:literal")
+      values[0].push_back(&st);
+    else if (st.predicate == "urn:test:uri")
+      values[1].push_back(&st);
+    else if (st.predicate == "urn:test:number")
+      values[2].push_back(&st);
+  }
+
+  const size_t num_literals = sizeof(literals) / sizeof(literals[0]);
+  check(values[0].size() == num_literals, "number of literals");
+  for (size_t i = 0; i < num_literals && i < values[0].size(); ++i) {
+    check(values[0][i]->object_type == SERD_LITERAL &&
+          values[0][i]->object == literals[i].expected,
+          std::string("literal: ") + literals[i].name);
+  }
+
+  const size_t num_uris = sizeof(uris) / sizeof(uris[0]);
+  check(values[1].size() == num_uris, "number of URIs");
+  for (size_t i = 0; i < num_uris && i < values[1].size(); ++i) {
+    check(values[1][i]->object_type == SERD_URI &&
+          values[1][i]->object == uris[i].expected,
+          std::string("URI: ") + uris[i].name);
+  }
+
+  const size_t num_numbers = sizeof(numbers) / sizeof(numbers[0]);
+  check(values[2].size() == num_numbers, "number of numbers");
+  for (size_t i = 0; i < num_numbers && i < values[2].size(); ++i) {
+    check(std::strtof(values[2][i]->object.c_str(), nullptr) == numbers[i],
+          "number: " + values[2][i]->object);
+  }
+}
+
+//==============================================================================
+typedef bool (write_manifest_fn_t)(const char *, bool);
+typedef const EffectManifest *(effect_manifest_fn_t)(uint32_t);
+
+static std::string make_temp_directory() {
+#if defined(_WIN32)
+  char path[MAX_PATH];
+  char name[MAX_PATH];
+  if (!GetTempPathA(sizeof(path), path) || !GetTempFileNameA(path, "ttl", 0, name))
+    return std::string();
+  DeleteFileA(name);
+  if (!CreateDirectoryA(name, nullptr))
+    return std::string();
+  return name;
+#else
+  const char *tmp = std::getenv("TMPDIR");
+  std::string path = std::string((tmp && tmp[0]) ? tmp : "/tmp") + "/manifesttest.XXXXXX";
+  if (!mkdtemp(&path[0]))
+    return std::string();
+  return path;
+#endif
+}
+
+static void remove_directory(const std::string &path, const std::vector<std::string> &files) {
+  for (const std::string &file : files)
+    std::remove((path + "/" + file).c_str());
+#if defined(_WIN32)
+  RemoveDirectoryA(path.c_str());
+#else
+  rmdir(path.c_str());
+#endif
+}
+
+static void test_manifest(write_manifest_fn_t *write_manifest,
+                          effect_manifest_fn_t *effect_manifest, bool single_file) {
+  const std::string layout = single_file ? "single file" : "separate files";
+
+  std::string directory = make_temp_directory();
+  if (directory.empty()) {
+    check(false, "creating a temporary directory");
+    return;
+  }
+
+  std::vector<std::string> files {"manifest.ttl"};
+  if (!single_file) {
+    files.push_back(std::string(effect_binary_file) + ".ttl");
+    files.push_back(std::string(ui_binary_file) + ".ttl");
+  }
+
+  check(write_manifest(directory.c_str(), single_file), layout + ": writing the manifest");
+
+  // every file is read in the same document, like the hosts do
+  Document doc;
+  for (const std::string &file : files) {
+    std::string path = directory + "/" + file;
+    FILE *fh = std::fopen(path.c_str(), "rb");
+    if (!fh) {
+      // the binary may have no UI
+      check(file == std::string(ui_binary_file) + ".ttl", layout + ": missing " + file);
+      continue;
+    }
+    std::fclose(fh);
+    bool ok = doc.read_file(path);
+    check(ok, layout + ": parsing " + file);
+    if (!ok)
+      print_errors(doc, file);
+  }
+
+  static const char rdf_type[] = "http://www.w3.org/1999/02/22-rdf-syntax-ns#type";
+  static const char lv2_plugin[] = "http://lv2plug.in/ns/lv2core#Plugin";
+  static const char lv2_port[] = "http://lv2plug.in/ns/lv2core#port";
+  static const char lv2_symbol[] = "http://lv2plug.in/ns/lv2core#symbol";
+  static const char doap_name[] = "http://usefulinc.com/ns/doap#name";
+
+  unsigned num_effects = 0;
+  for (const EffectManifest *m; (m = effect_manifest(num_effects)); ++num_effects) {
+    const std::string uri = m->uri;
+    check(doc.has(uri, rdf_type, lv2_plugin), layout + ": " + uri + " is a plugin");
+
+    const Statement *name = doc.find(uri, doap_name);
+    check(name && name->object_type == SERD_LITERAL && name->object == m->name,
+          layout + ": name of " + uri);
+
+    // each port is a blank node with the symbol of the description
+    size_t num_ports = 0;
+    for (const Statement &st : doc.statements) {
+      if (st.subject != uri || st.predicate != lv2_port)
+        continue;
+      const Statement *symbol = doc.find(st.object, lv2_symbol);
+      check(symbol && num_ports < m->ports.size() &&
+            symbol->object == m->ports[num_ports].symbol,
+            layout + ": port " + std::to_string(num_ports) + " of " + uri);
+      ++num_ports;
+    }
+    check(num_ports == m->ports.size(), layout + ": number of ports of " + uri);
+  }
+  check(num_effects > 0, layout + ": the binary has effects");
+
+  remove_directory(directory, files);
+}
+
+//==============================================================================
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    std::cerr << "Usage: manifesttest <effect-binary>\n";
+    return 1;
+  }
+
+  test_escaping();
+
+  std::string inputfile = argv[1];
+#if !defined(_WIN32)
+  if (inputfile.empty() || inputfile.front() != '/')
+    inputfile = "./" + inputfile;
+#endif
+
+#if defined(_WIN32)
+  HMODULE dlh = LoadLibraryA(inputfile.c_str());
+#else
+  void *dlh = dlopen(inputfile.c_str(), RTLD_LAZY);
+#endif
+  if (!dlh) {
+    std::cerr << "cannot load the library\n";
+    return 1;
+  }
+
+#if defined(_WIN32)
+  write_manifest_fn_t *write_manifest = (write_manifest_fn_t *)GetProcAddress(dlh, "lv2_write_manifest");
+  effect_manifest_fn_t *effect_manifest = (effect_manifest_fn_t *)GetProcAddress(dlh, "lv2_effect_manifest");
+#else
+  write_manifest_fn_t *write_manifest = (write_manifest_fn_t *)dlsym(dlh, "lv2_write_manifest");
+  effect_manifest_fn_t *effect_manifest = (effect_manifest_fn_t *)dlsym(dlh, "lv2_effect_manifest");
+#endif
+  if (!write_manifest || !effect_manifest) {
+    std::cerr << "cannot find the entry functions\n";
+    return 1;
+  }
+
+  test_manifest(write_manifest, effect_manifest, false);
+  test_manifest(write_manifest, effect_manifest, true);
+
+  if (failures > 0) {
+    std::cerr << failures << " failure(s)\n";
+    return 1;
+  }
+  std::cerr << "all tests passed\n";
+  return 0;
+}
@@ -0,0 +1,494 @@
+#include "framework/description.h"
+#include "framework/lv2all.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdexcept>
+#include <iostream>
+#include <cstring>
+#include <cmath>
+#if defined(_WIN32)
+# include <windows.h>
+#else
+# include <dlfcn.h>
+#endif
+
+// Headless host which measures the cost of the `run` function of an effect
+
+// hooks of the realtime checker, if it is preloaded (see rtcheck.cc)
+struct RTCheck {
+  void (*enter)() = nullptr;
+  void (*leave)() = nullptr;
+  unsigned long (*violations)() = nullptr;
+};
+
+static RTCheck rtcheck;
+
+struct Options {
+  std::string inputfile;
+  unsigned plugin = 0;
+  std::vector<unsigned> block_sizes {32, 64, 128, 256, 512, 1024, 2048};
+  std::vector<double> rates {44100, 48000, 96000};
+  double density = 20;
+  double duration = 10;
+  unsigned sequence_size = 8192;
+};
+
+//==============================================================================
+class URIDMap {
+ public:
+  URIDMap() {
+    map_.handle = this;
+    map_.map = [](LV2_URID_Map_Handle h, const char *uri) -> LV2_URID {
+      return reinterpret_cast<URIDMap *>(h)->map(uri); };
+    unmap_.handle = this;
+    unmap_.unmap = [](LV2_URID_Unmap_Handle h, LV2_URID urid) -> const char * {
+      return reinterpret_cast<URIDMap *>(h)->unmap(urid); };
+  }
+
+  LV2_URID map(const char *uri) {
+    auto it = ids_.find(uri);
+    if (it != ids_.end())
+      return it->second;
+    uris_.emplace_back(new std::string(uri));
+    LV2_URID id = uris_.size();
+    ids_[*uris_.back()] = id;
+    return id;
+  }
+
+  const char *unmap(LV2_URID urid) {
+    return (urid > 0 && urid <= uris_.size()) ? uris_[urid - 1]->c_str() : nullptr;
+  }
+
+  LV2_URID_Map *map_feature() { return &map_; }
+  LV2_URID_Unmap *unmap_feature() { return &unmap_; }
+
+ private:
+  LV2_URID_Map map_;
+  LV2_URID_Unmap unmap_;
+  std::unordered_map<std::string, LV2_URID> ids_;
+  std::vector<std::unique_ptr<std::string>> uris_;
+};
+
+//==============================================================================
+// worker which runs the jobs synchronously, at the time they are scheduled
+class SyncWorker {
+ public:
+  SyncWorker() {
+    schedule_.handle = this;
+    schedule_.schedule_work = &schedule_work;
+  }
+
+  void set_instance(LV2_Handle instance, const LV2_Worker_Interface *intf) {
+    instance_ = instance;
+    intf_ = intf;
+  }
+
+  void end_run() {
+    if (!intf_)
+      return;
+    for (const std::vector<uint8_t> &r : responses_)
+      intf_->work_response(instance_, r.size(), r.data());
+    responses_.clear();
+    if (intf_->end_run)
+      intf_->end_run(instance_);
+  }
+
+  LV2_Worker_Schedule *feature() { return &schedule_; }
+
+ private:
+  static LV2_Worker_Status schedule_work(
+      LV2_Worker_Schedule_Handle h, uint32_t size, const void *data) {
+    SyncWorker *self = reinterpret_cast<SyncWorker *>(h);
+    if (!self->intf_)
+      return LV2_WORKER_ERR_UNKNOWN;
+    return self->intf_->work(self->instance_, &respond, self, size, data);
+  }
+
+  static LV2_Worker_Status respond(
+      LV2_Worker_Respond_Handle h, uint32_t size, const void *data) {
+    SyncWorker *self = reinterpret_cast<SyncWorker *>(h);
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+    self->responses_.emplace_back(bytes, bytes + size);
+    return LV2_WORKER_SUCCESS;
+  }
+
+ private:
+  LV2_Worker_Schedule schedule_;
+  LV2_Handle instance_ = nullptr;
+  const LV2_Worker_Interface *intf_ = nullptr;
+  std::vector<std::vector<uint8_t>> responses_;
+};
+
+//==============================================================================
+// generator of a MIDI note stream with a given average density
+class NoteGenerator {
+ public:
+  NoteGenerator(double events_per_second, double rate)
+      : interval_(rate / std::max(1e-3, events_per_second)) {}
+
+  template <class F> void generate(unsigned nframes, F &&emit) {
+    std::uniform_int_distribution<int> note_dist(36, 96);
+    std::exponential_distribution<double> interval_dist(1 / interval_);
+    while (next_ < nframes) {
+      uint8_t msg[3];
+      if (held_.size() < 16 && (held_.empty() || (prng_() & 1))) {
+        uint8_t note = note_dist(prng_);
+        msg[0] = 0x90; msg[1] = note; msg[2] = 100;
+        held_.push_back(note);
+      }
+      else {
+        msg[0] = 0x80; msg[1] = held_.front(); msg[2] = 0;
+        held_.pop_front();
+      }
+      emit(unsigned(next_), msg, 3);
+      next_ += interval_dist(prng_);
+    }
+    next_ -= nframes;
+  }
+
+ private:
+  double interval_ = 0;
+  double next_ = 0;
+  std::minstd_rand prng_;
+  std::deque<uint8_t> held_;
+};
+
+//==============================================================================
+struct Result {
+  double rate;
+  unsigned block_size;
+  unsigned nblocks;
+  unsigned nevents;
+  double ns_per_sample;
+  double p50, p99, p999, max;
+  double realtime_factor;
+};
+
+static int run_lv2bench(int argc, char *argv[]);
+static Result run_benchmark(const LV2_Descriptor *desc, const EffectManifest &m,
+                            const Options &opt, double rate, unsigned block_size,
+                            const char *bundle_path);
+static void print_result(std::ostream &os, const Result &r);
+static void print_string(std::ostream &os, const char *str);
+static std::string dirname(const std::string &path);
+
+int main(int argc, char *argv[]) {
+  // the failures to load and run the plugin are exceptions, reported by the
+  // exit status
+  try {
+    return run_lv2bench(argc, argv);
+  }
+  catch (const std::exception &ex) {
+    std::cerr << "error: " << ex.what() << "\n";
+    return 1;
+  }
+}
+
+static int run_lv2bench(int argc, char *argv[]) {
+  Options opt;
+
+  auto parse_list = [](const char *arg, auto conv) {
+    std::vector<decltype(conv(std::string()))> list;
+    std::string str = arg;
+    for (size_t pos = 0, end; pos <= str.size(); pos = end + 1) {
+      end = std::min(str.find(',', pos), str.size());
+      list.push_back(conv(str.substr(pos, end - pos)));
+    }
+    return list;
+  };
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "-b" && has_value)
+      opt.block_sizes = parse_list(argv[++i], [](const std::string &s) { return unsigned(std::stoul(s)); });
+    else if (arg == "-r" && has_value)
+      opt.rates = parse_list(argv[++i], [](const std::string &s) { return std::stod(s); });
+    else if (arg == "-d" && has_value)
+      opt.density = std::stod(argv[++i]);
+    else if (arg == "-t" && has_value)
+      opt.duration = std::stod(argv[++i]);
+    else if (arg == "-p" && has_value)
+      opt.plugin = std::stoul(argv[++i]);
+    else if (!arg.empty() && arg[0] != '-' && opt.inputfile.empty())
+      opt.inputfile = arg;
+    else {
+      opt.inputfile.clear();
+      break;
+    }
+  }
+
+  if (opt.inputfile.empty() || opt.block_sizes.empty() || opt.rates.empty()) {
+    std::cerr << "Usage: lv2bench [-b block-sizes] [-r rates] [-d events-per-second]"
+        " [-t seconds] [-p plugin-index] <input-file>\n";
+    return 1;
+  }
+
+#if !defined(_WIN32)
+  rtcheck.enter = (void (*)())dlsym(RTLD_DEFAULT, "rtcheck_enter");
+  rtcheck.leave = (void (*)())dlsym(RTLD_DEFAULT, "rtcheck_leave");
+  rtcheck.violations = (unsigned long (*)())dlsym(RTLD_DEFAULT, "rtcheck_violations");
+  if (!rtcheck.enter || !rtcheck.leave || !rtcheck.violations)
+    rtcheck = RTCheck();
+#endif
+
+  std::string inputfile = opt.inputfile;
+#if !defined(_WIN32)
+  if (inputfile.front() != '/')
+    inputfile = "./" + inputfile;
+#endif
+
+#if defined(_WIN32)
+  HMODULE dlh = LoadLibraryA(inputfile.c_str());
+#else
+  void *dlh = dlopen(inputfile.c_str(), RTLD_NOW);
+#endif
+  if (!dlh)
+    throw std::runtime_error("cannot load the library");
+
+  typedef const LV2_Descriptor *(descriptor_fn_t)(uint32_t);
+  typedef const EffectManifest *(manifest_fn_t)(uint32_t);
+#if defined(_WIN32)
+  descriptor_fn_t *descriptor_fn = (descriptor_fn_t *)GetProcAddress(dlh, "lv2_descriptor");
+  manifest_fn_t *manifest_fn = (manifest_fn_t *)GetProcAddress(dlh, "lv2_effect_manifest");
+#else
+  descriptor_fn_t *descriptor_fn = (descriptor_fn_t *)dlsym(dlh, "lv2_descriptor");
+  manifest_fn_t *manifest_fn = (manifest_fn_t *)dlsym(dlh, "lv2_effect_manifest");
+#endif
+  if (!descriptor_fn || !manifest_fn)
+    throw std::runtime_error("cannot find the entry function");
+
+  const LV2_Descriptor *desc = descriptor_fn(opt.plugin);
+  const EffectManifest *m = manifest_fn(opt.plugin);
+  if (!desc || !m)
+    throw std::runtime_error("cannot get the plugin description");
+
+  std::string bundle_path = dirname(inputfile) + "/";
+
+  std::cout << "{\n";
+  std::cout << "  \"plugin\": ";
+  print_string(std::cout, desc->URI);
+  std::cout << ",\n";
+  std::cout << "  \"density\": " << opt.density << ",\n";
+  std::cout << "  \"results\": [";
+  bool first = true;
+  for (double rate : opt.rates) {
+    for (unsigned block_size : opt.block_sizes) {
+      Result r = run_benchmark(desc, *m, opt, rate, block_size, bundle_path.c_str());
+      std::cout << (first ? "" : ",") << "\n    ";
+      print_result(std::cout, r);
+      first = false;
+    }
+  }
+  std::cout << "\n  ]";
+  unsigned long violations = 0;
+  if (rtcheck.violations) {
+    violations = rtcheck.violations();
+    std::cout << ",\n  \"realtime_violations\": " << violations;
+  }
+  std::cout << "\n}\n";
+
+  return (violations > 0) ? 2 : 0;
+}
+
+//==============================================================================
+static Result run_benchmark(const LV2_Descriptor *desc, const EffectManifest &m,
+                            const Options &opt, double rate, unsigned block_size,
+                            const char *bundle_path) {
+  URIDMap urid;
+  SyncWorker worker;
+
+  const LV2_URID atom_int = urid.map(LV2_ATOM__Int);
+  const LV2_URID atom_sequence = urid.map(LV2_ATOM__Sequence);
+  const LV2_URID atom_chunk = urid.map(LV2_ATOM__Chunk);
+  const LV2_URID atom_frame_time = urid.map(LV2_ATOM__frameTime);
+  const LV2_URID midi_event = urid.map(LV2_MIDI__MidiEvent);
+
+  const int32_t max_block_length = block_size;
+  const int32_t sequence_size = opt.sequence_size;
+  const LV2_Options_Option options[] = {
+    {LV2_OPTIONS_INSTANCE, 0, urid.map(LV2_BUF_SIZE__maxBlockLength),
+     sizeof(int32_t), atom_int, &max_block_length},
+    {LV2_OPTIONS_INSTANCE, 0, urid.map(LV2_BUF_SIZE__nominalBlockLength),
+     sizeof(int32_t), atom_int, &max_block_length},
+    {LV2_OPTIONS_INSTANCE, 0, urid.map(LV2_BUF_SIZE__sequenceSize),
+     sizeof(int32_t), atom_int, &sequence_size},
+    {LV2_OPTIONS_INSTANCE, 0, 0, 0, 0, nullptr},
+  };
+
+  const LV2_Feature map_feature = {LV2_URID__map, urid.map_feature()};
+  const LV2_Feature unmap_feature = {LV2_URID__unmap, urid.unmap_feature()};
+  const LV2_Feature options_feature = {LV2_OPTIONS__options, const_cast<LV2_Options_Option *>(options)};
+  const LV2_Feature bounded_feature = {LV2_BUF_SIZE__boundedBlockLength, nullptr};
+  const LV2_Feature worker_feature = {LV2_WORKER__schedule, worker.feature()};
+  const LV2_Feature *features[] = {
+    &map_feature, &unmap_feature, &options_feature, &bounded_feature,
+    &worker_feature, nullptr,
+  };
+
+  LV2_Handle instance = desc->instantiate(desc, rate, bundle_path, features);
+  if (!instance)
+    throw std::runtime_error("cannot instantiate the plugin");
+
+  if (desc->extension_data)
+    worker.set_instance(instance, reinterpret_cast<const LV2_Worker_Interface *>(
+                            desc->extension_data(LV2_WORKER__interface)));
+
+  // allocate and connect the port buffers
+  const size_t nports = m.ports.size();
+  std::vector<std::vector<float>> audio_buffers(nports);
+  std::vector<float> control_values(nports);
+  std::vector<std::unique_ptr<uint64_t[]>> atom_buffers(nports);
+  std::vector<size_t> input_sequences, output_sequences;
+
+  for (size_t i = 0; i < nports; ++i) {
+    const Port &port = m.ports[i];
+    void *data = nullptr;
+    switch (port.kind) {
+      case PortKind::Audio:
+        audio_buffers[i].resize(block_size);
+        data = audio_buffers[i].data();
+        break;
+      case PortKind::Control:
+        control_values[i] = port.default_value;
+        data = &control_values[i];
+        break;
+      case PortKind::Event:
+        atom_buffers[i].reset(new uint64_t[(opt.sequence_size + 7) / 8]());
+        data = atom_buffers[i].get();
+        ((port.direction == PortDirection::Input) ?
+         input_sequences : output_sequences).push_back(i);
+        break;
+    }
+    desc->connect_port(instance, i, data);
+  }
+
+  if (desc->activate)
+    desc->activate(instance);
+
+  NoteGenerator notes(opt.density, rate);
+  const unsigned warmup_blocks = 16;
+  const unsigned nblocks = std::max(1.0, opt.duration * rate / block_size);
+  std::vector<double> times;
+  times.reserve(nblocks);
+  unsigned nevents = 0;
+
+  typedef std::chrono::steady_clock clock;
+  for (unsigned b = 0; b < warmup_blocks + nblocks; ++b) {
+    for (size_t i : input_sequences) {
+      LV2_Atom_Sequence *seq = reinterpret_cast<LV2_Atom_Sequence *>(atom_buffers[i].get());
+      seq->atom.type = atom_sequence;
+      seq->atom.size = sizeof(LV2_Atom_Sequence_Body);
+      seq->body.unit = atom_frame_time;
+      seq->body.pad = 0;
+    }
+    notes.generate(block_size, [&](unsigned frame, const uint8_t *msg, uint32_t size) {
+      struct {
+        LV2_Atom_Event header;
+        uint8_t data[8];
+      } ev;
+      ev.header.time.frames = frame;
+      ev.header.body.type = midi_event;
+      ev.header.body.size = size;
+      std::memcpy(ev.data, msg, size);
+      for (size_t i : input_sequences) {
+        LV2_Atom_Sequence *seq = reinterpret_cast<LV2_Atom_Sequence *>(atom_buffers[i].get());
+        // the capacity is that of the body, without the atom header
+        lv2_atom_sequence_append_event(seq, opt.sequence_size - sizeof(LV2_Atom), &ev.header);
+      }
+      nevents += (b >= warmup_blocks);
+    });
+    for (size_t i : output_sequences) {
+      LV2_Atom_Sequence *seq = reinterpret_cast<LV2_Atom_Sequence *>(atom_buffers[i].get());
+      // an empty chunk, whose size is the capacity, as the output of a host
+      seq->atom.type = atom_chunk;
+      seq->atom.size = opt.sequence_size - sizeof(LV2_Atom);
+    }
+
+    clock::time_point t1 = clock::now();
+    if (rtcheck.enter)
+      rtcheck.enter();
+    desc->run(instance, block_size);
+    if (rtcheck.leave)
+      rtcheck.leave();
+    clock::time_point t2 = clock::now();
+    worker.end_run();
+
+    if (b >= warmup_blocks)
+      times.push_back(std::chrono::duration<double>(t2 - t1).count());
+  }
+
+  if (desc->deactivate)
+    desc->deactivate(instance);
+  desc->cleanup(instance);
+
+  Result r;
+  r.rate = rate;
+  r.block_size = block_size;
+  r.nblocks = nblocks;
+  r.nevents = nevents;
+
+  double total = 0;
+  for (double t : times)
+    total += t;
+  r.ns_per_sample = total * 1e9 / (double(nblocks) * block_size);
+  r.realtime_factor = (double(nblocks) * block_size / rate) / total;
+
+  std::sort(times.begin(), times.end());
+  auto percentile = [&times](double p) -> double {
+    size_t index = std::min(times.size() - 1, size_t(p * times.size()));
+    return times[index];
+  };
+  r.p50 = percentile(0.5);
+  r.p99 = percentile(0.99);
+  r.p999 = percentile(0.999);
+  r.max = times.back();
+
+  return r;
+}
+
+static void print_result(std::ostream &os, const Result &r) {
+  os << "{\"rate\": " << r.rate
+     << ", \"block_size\": " << r.block_size
+     << ", \"blocks\": " << r.nblocks
+     << ", \"events\": " << r.nevents
+     << ", \"ns_per_sample\": " << r.ns_per_sample
+     << ", \"block_ns_p50\": " << uint64_t(r.p50 * 1e9)
+     << ", \"block_ns_p99\": " << uint64_t(r.p99 * 1e9)
+     << ", \"block_ns_p999\": " << uint64_t(r.p999 * 1e9)
+     << ", \"block_ns_max\": " << uint64_t(r.max * 1e9)
+     << ", \"realtime_factor\": ";
+  // infinite when the run is too short to measure, which JSON cannot express
+  if (std::isfinite(r.realtime_factor))
+    os << r.realtime_factor;
+  else
+    os << "null";
+  os << "}";
+}
+
+static void print_string(std::ostream &os, const char *str) {
+  os << '"';
+  for (const char *p = str; *p; ++p) {
+    unsigned char c = *p;
+    if (c == '"' || c == '\\')
+      os << '\\' << c;
+    else if (c < 0x20) {
+      static const char hex[] = "0123456789abcdef";
+      os << "\\u00" << hex[c >> 4] << hex[c & 15];
+    }
+    else
+      os << c;
+  }
+  os << '"';
+}
+
+static std::string dirname(const std::string &path) {
+  size_t pos = path.find_last_of("/\\");
+  return (pos == std::string::npos) ? "." : path.substr(0, pos);
+}
@@ -0,0 +1,240 @@
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb_truetype.h>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+
+// Build tool which rasterizes the glyphs of fonts into an atlas, and writes it
+// as C++ source which defines `font_atlas_data()` (see fontatlas.h)
+//
+// Usage: makefontatlas <output> [<face> <font-file> <size> <ranges>]...
+// The ranges of codepoints are separated by commas, like "32-126,176".
+
+struct Glyph {
+  uint32_t codepoint = 0;
+  unsigned x = 0, y = 0, width = 0, height = 0;
+  int left = 0, top = 0;
+  int advance = 0;
+  std::vector<uint8_t> bitmap;
+};
+
+struct Kerning {
+  uint32_t first = 0, second = 0;
+  int advance = 0;
+};
+
+struct Face {
+  std::string name;
+  float size = 0;
+  float ascender = 0, descender = 0, line_height = 0;
+  std::vector<Glyph> glyphs;
+  std::vector<Kerning> kerning;
+};
+
+static std::vector<uint32_t> parse_ranges(const std::string &str);
+static Face rasterize_face(const std::string &name, const std::string &file, float size, const std::vector<uint32_t> &codepoints);
+static void pack_glyphs(std::vector<Face> &faces, unsigned width, unsigned &height);
+static void write_source(std::ostream &os, const std::vector<Face> &faces, unsigned width, unsigned height);
+
+int main(int argc, char *argv[]) {
+  if (argc < 2 || (argc - 2) % 4 != 0) {
+    std::cerr << "Usage: makefontatlas <output> [<face> <font-file> <size> <ranges>]...\n";
+    return 1;
+  }
+
+  std::vector<Face> faces;
+  for (int i = 2; i < argc; i += 4) {
+    float size = std::stof(argv[i + 2]);
+    faces.push_back(rasterize_face(argv[i], argv[i + 1], size, parse_ranges(argv[i + 3])));
+  }
+
+  const unsigned width = 512;
+  unsigned height = 0;
+  pack_glyphs(faces, width, height);
+
+  std::ofstream out(argv[1], std::ios::binary);
+  write_source(out, faces, width, height);
+  out.flush();
+  if (!out) {
+    std::cerr << "cannot write the output: " << argv[1] << "\n";
+    return 1;
+  }
+
+  return 0;
+}
+
+//==============================================================================
+static std::vector<uint32_t> parse_ranges(const std::string &str) {
+  std::vector<uint32_t> codepoints;
+  for (size_t pos = 0, end; pos < str.size(); pos = end + 1) {
+    end = std::min(str.find(',', pos), str.size());
+    std::string range = str.substr(pos, end - pos);
+    size_t dash = range.find('-');
+    uint32_t first = std::stoul(range.substr(0, dash), nullptr, 0);
+    uint32_t last = (dash == range.npos) ? first : std::stoul(range.substr(dash + 1), nullptr, 0);
+    for (uint32_t c = first; c <= last; ++c)
+      codepoints.push_back(c);
+  }
+  std::sort(codepoints.begin(), codepoints.end());
+  codepoints.erase(std::unique(codepoints.begin(), codepoints.end()), codepoints.end());
+  return codepoints;
+}
+
+static Face rasterize_face(const std::string &name, const std::string &file, float size, const std::vector<uint32_t> &codepoints) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in)
+    throw std::runtime_error("cannot read the font: " + file);
+  std::vector<unsigned char> data(
+      (std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+  stbtt_fontinfo font;
+  if (!stbtt_InitFont(&font, data.data(), stbtt_GetFontOffsetForIndex(data.data(), 0)))
+    throw std::runtime_error("cannot load the font: " + file);
+
+  // the size is the height from descender to ascender, as in fontstash
+  const float scale = stbtt_ScaleForPixelHeight(&font, size);
+  int ascent, descent, line_gap;
+  stbtt_GetFontVMetrics(&font, &ascent, &descent, &line_gap);
+
+  Face face;
+  face.name = name;
+  face.size = size;
+  face.ascender = ascent * scale;
+  face.descender = descent * scale;
+  face.line_height = (ascent - descent + line_gap) * scale;
+
+  std::vector<int> indices;
+  for (uint32_t codepoint : codepoints) {
+    int index = stbtt_FindGlyphIndex(&font, codepoint);
+    if (index == 0)
+      continue;
+
+    Glyph glyph;
+    glyph.codepoint = codepoint;
+    int advance, bearing;
+    stbtt_GetGlyphHMetrics(&font, index, &advance, &bearing);
+    glyph.advance = int(advance * scale + 0.5f);
+
+    int x0, y0, x1, y1;
+    stbtt_GetGlyphBitmapBox(&font, index, scale, scale, &x0, &y0, &x1, &y1);
+    glyph.left = x0;
+    glyph.top = y0;
+    glyph.width = std::max(0, x1 - x0);
+    glyph.height = std::max(0, y1 - y0);
+    glyph.bitmap.resize(glyph.width * glyph.height);
+    if (!glyph.bitmap.empty())
+      stbtt_MakeGlyphBitmap(
+          &font, glyph.bitmap.data(), glyph.width, glyph.height, glyph.width,
+          scale, scale, index);
+
+    face.glyphs.push_back(std::move(glyph));
+    indices.push_back(index);
+  }
+
+  for (size_t i = 0, n = face.glyphs.size(); i < n; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      int advance = int(stbtt_GetGlyphKernAdvance(&font, indices[i], indices[j]) * scale + 0.5f);
+      if (advance == 0)
+        continue;
+      Kerning kerning;
+      kerning.first = face.glyphs[i].codepoint;
+      kerning.second = face.glyphs[j].codepoint;
+      kerning.advance = advance;
+      face.kerning.push_back(kerning);
+    }
+  }
+
+  return face;
+}
+
+// place the glyphs on shelves, the tallest first, with a pixel of padding
+static void pack_glyphs(std::vector<Face> &faces, unsigned width, unsigned &height) {
+  std::vector<Glyph *> glyphs;
+  for (Face &face : faces) {
+    for (Glyph &glyph : face.glyphs) {
+      if (glyph.width > 0 && glyph.height > 0)
+        glyphs.push_back(&glyph);
+    }
+  }
+  std::stable_sort(glyphs.begin(), glyphs.end(), [](const Glyph *a, const Glyph *b) {
+    return a->height > b->height; });
+
+  const unsigned padding = 1;
+  unsigned x = padding, y = padding, shelf_height = 0;
+  for (Glyph *glyph : glyphs) {
+    if (glyph->width + 2 * padding > width)
+      throw std::runtime_error("the glyph is too large for the atlas");
+    if (x + glyph->width + padding > width) {
+      x = padding;
+      y += shelf_height + padding;
+      shelf_height = 0;
+    }
+    glyph->x = x;
+    glyph->y = y;
+    x += glyph->width + padding;
+    shelf_height = std::max(shelf_height, glyph->height);
+  }
+  height = y + shelf_height + padding;
+  if (height > 0xffff)
+    throw std::runtime_error("the atlas is too large");
+}
+
+static void write_source(std::ostream &os, const std::vector<Face> &faces, unsigned width, unsigned height) {
+  std::vector<uint8_t> pixels(width * height);
+  for (const Face &face : faces) {
+    for (const Glyph &glyph : face.glyphs) {
+      for (unsigned r = 0; r < glyph.height; ++r)
+        std::copy_n(&glyph.bitmap[r * glyph.width], glyph.width,
+                    &pixels[(glyph.y + r) * width + glyph.x]);
+    }
+  }
+
+  char buf[256];
+  os << "// generated by makefontatlas, do not edit\n";
+  os << "#include \"framework/fontatlas.h\"\n\n";
+
+  os << "static const uint8_t atlas_pixels[" << std::max(1u, width * height) << "] = {";
+  for (size_t i = 0, n = pixels.size(); i < n; ++i)
+    os << ((i % 24) ? "" : "\n ") << ' ' << unsigned(pixels[i]) << ',';
+  os << "\n};\n";
+
+  for (size_t f = 0; f < faces.size(); ++f) {
+    const Face &face = faces[f];
+    os << "\nstatic const FontAtlasGlyph face" << f << "_glyphs[] = {\n";
+    for (const Glyph &g : face.glyphs) {
+      std::snprintf(buf, sizeof(buf), "  {%u, %u, %u, %u, %u, %d, %d, %d},\n",
+                    g.codepoint, g.x, g.y, g.width, g.height, g.left, g.top, g.advance);
+      os << buf;
+    }
+    os << "  {},\n};\n";
+    os << "\nstatic const FontAtlasKerning face" << f << "_kerning[] = {\n";
+    for (const Kerning &k : face.kerning) {
+      std::snprintf(buf, sizeof(buf), "  {%u, %u, %d},\n", k.first, k.second, k.advance);
+      os << buf;
+    }
+    os << "  {},\n};\n";
+  }
+
+  os << "\nstatic const FontAtlasFace atlas_faces[] = {\n";
+  for (size_t f = 0; f < faces.size(); ++f) {
+    const Face &face = faces[f];
+    std::snprintf(buf, sizeof(buf), "  {\"%s\", %.9g, %.9g, %.9g, %.9g, ",
+                  face.name.c_str(), face.size, face.ascender, face.descender, face.line_height);
+    os << buf << "face" << f << "_glyphs, " << face.glyphs.size() << ", "
+       << "face" << f << "_kerning, " << face.kerning.size() << "},\n";
+  }
+  os << "  {},\n};\n";
+
+  os << "\nconst FontAtlasData &font_atlas_data() {\n";
+  os << "  static const FontAtlasData data = {\n";
+  os << "    " << width << ", " << height << ", atlas_pixels, atlas_faces, " << faces.size() << ",\n";
+  os << "  };\n";
+  os << "  return data;\n";
+  os << "}\n";
+}
@@ -0,0 +1,106 @@
+#include "framework/threadpool.h"
+#include "framework/voices.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+// Measures the rendering of a full voice pool split on 1 to N threads
+
+struct Job {
+  VoicePool *voices;
+  std::vector<float> *parts;
+  unsigned nframes;
+  unsigned num_parts;
+};
+
+static double measure(unsigned num_threads, unsigned num_voices,
+                      unsigned nframes, unsigned nblocks, double rate) {
+  VoicePool voices(num_voices, rate);
+  voices.set_release(1e3f);
+  for (unsigned i = 0; i < num_voices; ++i)
+    voices.note_on(i % 128, 100);
+
+  std::unique_ptr<ThreadPool> pool(new ThreadPool(num_threads - 1));
+  // the parts in the slots of the worker and the caller
+  std::vector<float> parts[2 * 64];
+  for (unsigned i = 0; i < 2 * num_threads; ++i)
+    parts[i].resize(nframes);
+  std::vector<float> mix(nframes);
+
+  Job job { &voices, parts, nframes, num_threads };
+  auto task = [](void *data, unsigned part, unsigned slot) {
+    const Job &job = *reinterpret_cast<Job *>(data);
+    float *out = job.parts[slot * job.num_parts + part].data();
+    std::fill_n(out, job.nframes, 0);
+    job.voices->render_part(out, job.nframes, part, job.num_parts, slot);
+  };
+  auto setup = [](void *data) {
+    const Job &job = *reinterpret_cast<Job *>(data);
+    job.voices->snapshot();
+  };
+
+  // the workers have the duration of the block to finish their parts
+  const std::chrono::nanoseconds timeout(int64_t(1e9 * nframes / rate));
+
+  typedef std::chrono::steady_clock clock;
+  clock::time_point start = clock::now();
+  for (unsigned b = 0; b < nblocks; ++b) {
+    uint64_t slots = pool->run(task, setup, &job, num_threads, timeout);
+    voices.collect(num_threads, slots);
+    std::copy_n(parts[(slots & 1) * num_threads].data(), nframes, mix.data());
+    for (unsigned p = 1; p < num_threads; ++p) {
+      const float *part = parts[((slots >> p) & 1) * num_threads + p].data();
+      for (unsigned i = 0; i < nframes; ++i)
+        mix[i] += part[i];
+    }
+  }
+  clock::time_point end = clock::now();
+
+  // the buffers outlive the workers which are late
+  pool->wait_idle();
+
+  return std::chrono::duration<double>(end - start).count() / nblocks;
+}
+
+int main(int argc, char *argv[]) {
+  unsigned max_threads = std::thread::hardware_concurrency();
+  unsigned num_voices = 128;
+  unsigned nframes = 256;
+  unsigned nblocks = 2000;
+  double rate = 48000;
+
+  if (argc > 1)
+    max_threads = std::stoi(argv[1]);
+  if (argc > 2)
+    num_voices = std::stoi(argv[2]);
+  if (argc > 3)
+    nframes = std::stoi(argv[3]);
+
+  max_threads = std::max(1u, std::min(max_threads, 64u));
+
+  std::cout << "{\n"
+            << "  \"voices\": " << num_voices << ",\n"
+            << "  \"frames\": " << nframes << ",\n"
+            << "  \"rate\": " << rate << ",\n"
+            << "  \"results\": [";
+
+  double reference = 0;
+  for (unsigned n = 1; n <= max_threads; ++n) {
+    double t = measure(n, num_voices, nframes, nblocks, rate);
+    if (n == 1)
+      reference = t;
+    double budget = nframes / rate;
+    std::cout << ((n > 1) ? "," : "") << "\n    {"
+              << "\"threads\": " << n << ", "
+              << "\"ns_per_block\": " << uint64_t(t * 1e9) << ", "
+              << "\"speedup\": " << reference / t << ", "
+              << "\"load\": " << t / budget << "}";
+  }
+  std::cout << "\n  ]\n}\n";
+
+  return 0;
+}
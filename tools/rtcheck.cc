@@ -0,0 +1,329 @@
+// Preloadable library which detects the calls unsafe for realtime
+//
+// Memory allocation, locking, and file and socket I/O are reported, with a
+// backtrace, when they occur in a thread marked as being in realtime context.
+// A host marks this context with the functions `rtcheck_enter` and
+// `rtcheck_leave`, which it finds dynamically if the library is preloaded.
+//
+//     LD_PRELOAD=librtcheck.so lv2bench ...
+
+#undef _FORTIFY_SOURCE
+#if !defined(_GNU_SOURCE)
+# define _GNU_SOURCE 1
+#endif
+#include <atomic>
+#include <new>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+}
+
+static __thread int rt_depth = 0;
+static __thread int rt_reporting = 0;
+static std::atomic<unsigned long> rt_violations {0};
+static constexpr unsigned long max_reports = 32;
+
+//==============================================================================
+extern "C" __attribute__((visibility("default")))
+void rtcheck_enter() {
+  ++rt_depth;
+}
+
+extern "C" __attribute__((visibility("default")))
+void rtcheck_leave() {
+  --rt_depth;
+}
+
+extern "C" __attribute__((visibility("default")))
+unsigned long rtcheck_violations() {
+  return rt_violations.load();
+}
+
+//==============================================================================
+template <class F> static F *next_symbol(F *, const char *name) {
+  return reinterpret_cast<F *>(dlsym(RTLD_NEXT, name));
+}
+
+#define REAL(name) \
+  static decltype(&::name) real_##name = next_symbol(&::name, #name)
+
+static ssize_t raw_write(int fd, const void *data, size_t size);
+
+static void report(const char *what) {
+  if (rt_depth <= 0 || rt_reporting)
+    return;
+
+  unsigned long count = rt_violations.fetch_add(1) + 1;
+  if (count > max_reports)
+    return;
+
+  rt_reporting = 1;
+  char msg[256];
+  int n = snprintf(msg, sizeof(msg),
+                   "rtcheck: %s called in realtime context\n", what);
+  if (n > 0)
+    raw_write(2, msg, (size_t(n) < sizeof(msg)) ? size_t(n) : sizeof(msg) - 1);
+  void *frames[64];
+  int num_frames = backtrace(frames, 64);
+  backtrace_symbols_fd(frames + 1, num_frames - 1, 2);
+  if (count == max_reports) {
+    static const char last[] = "rtcheck: further violations are not reported\n";
+    raw_write(2, last, sizeof(last) - 1);
+  }
+  rt_reporting = 0;
+}
+
+__attribute__((constructor))
+static void rtcheck_init() {
+  // backtrace() allocates the first time it is used
+  void *frames[1];
+  backtrace(frames, 1);
+}
+
+__attribute__((destructor))
+static void rtcheck_fini() {
+  unsigned long count = rt_violations.load();
+  if (count > 0) {
+    char msg[128];
+    int n = snprintf(msg, sizeof(msg), "rtcheck: %lu violations\n", count);
+    if (n > 0)
+      raw_write(2, msg, (size_t(n) < sizeof(msg)) ? size_t(n) : sizeof(msg) - 1);
+  }
+}
+
+//==============================================================================
+// memory
+
+extern "C" void *malloc(size_t size) {
+  report("malloc()");
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) {
+  report("calloc()");
+  return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) {
+  report("realloc()");
+  return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void *ptr) {
+  if (ptr)
+    report("free()");
+  __libc_free(ptr);
+}
+
+extern "C" int posix_memalign(void **ptr, size_t alignment, size_t size) {
+  report("posix_memalign()");
+  void *p = __libc_memalign(alignment, size);
+  if (!p)
+    return ENOMEM;
+  *ptr = p;
+  return 0;
+}
+
+extern "C" void *aligned_alloc(size_t alignment, size_t size) {
+  report("aligned_alloc()");
+  return __libc_memalign(alignment, size);
+}
+
+static void *checked_new(size_t size, const char *what) {
+  report(what);
+  void *p = __libc_malloc(size ? size : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+static void checked_delete(void *ptr, const char *what) {
+  if (ptr)
+    report(what);
+  __libc_free(ptr);
+}
+
+void *operator new(size_t size) {
+  return checked_new(size, "operator new");
+}
+
+void *operator new[](size_t size) {
+  return checked_new(size, "operator new[]");
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  report("operator new");
+  return __libc_malloc(size ? size : 1);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  report("operator new[]");
+  return __libc_malloc(size ? size : 1);
+}
+
+void operator delete(void *ptr) noexcept {
+  checked_delete(ptr, "operator delete");
+}
+
+void operator delete[](void *ptr) noexcept {
+  checked_delete(ptr, "operator delete[]");
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+  checked_delete(ptr, "operator delete");
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+  checked_delete(ptr, "operator delete[]");
+}
+
+//==============================================================================
+// locking
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t *mutex) {
+  REAL(pthread_mutex_lock);
+  report("pthread_mutex_lock()");
+  return real_pthread_mutex_lock(mutex);
+}
+
+extern "C" int pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex) {
+  // the symbol is versioned, and the default lookup finds an old version
+  static auto real_pthread_cond_wait = []() {
+    void *sym = dlvsym(RTLD_NEXT, "pthread_cond_wait", "GLIBC_2.3.2");
+    if (!sym)
+      sym = dlsym(RTLD_NEXT, "pthread_cond_wait");
+    return reinterpret_cast<decltype(&::pthread_cond_wait)>(sym);
+  }();
+  report("pthread_cond_wait()");
+  return real_pthread_cond_wait(cond, mutex);
+}
+
+extern "C" int pthread_rwlock_rdlock(pthread_rwlock_t *lock) {
+  REAL(pthread_rwlock_rdlock);
+  report("pthread_rwlock_rdlock()");
+  return real_pthread_rwlock_rdlock(lock);
+}
+
+extern "C" int pthread_rwlock_wrlock(pthread_rwlock_t *lock) {
+  REAL(pthread_rwlock_wrlock);
+  report("pthread_rwlock_wrlock()");
+  return real_pthread_rwlock_wrlock(lock);
+}
+
+extern "C" int sem_wait(sem_t *sem) {
+  REAL(sem_wait);
+  report("sem_wait()");
+  return real_sem_wait(sem);
+}
+
+//==============================================================================
+// files and sockets
+
+extern "C" int open(const char *path, int flags, ...) {
+  REAL(open);
+  report("open()");
+  mode_t mode = 0;
+  if (flags & (O_CREAT|O_TMPFILE)) {
+    va_list ap;
+    va_start(ap, flags);
+    mode = va_arg(ap, mode_t);
+    va_end(ap);
+  }
+  return real_open(path, flags, mode);
+}
+
+extern "C" int openat(int dirfd, const char *path, int flags, ...) {
+  REAL(openat);
+  report("openat()");
+  mode_t mode = 0;
+  if (flags & (O_CREAT|O_TMPFILE)) {
+    va_list ap;
+    va_start(ap, flags);
+    mode = va_arg(ap, mode_t);
+    va_end(ap);
+  }
+  return real_openat(dirfd, path, flags, mode);
+}
+
+extern "C" FILE *fopen(const char *path, const char *mode) {
+  REAL(fopen);
+  report("fopen()");
+  return real_fopen(path, mode);
+}
+
+extern "C" int close(int fd) {
+  REAL(close);
+  report("close()");
+  return real_close(fd);
+}
+
+extern "C" ssize_t read(int fd, void *data, size_t size) {
+  REAL(read);
+  report("read()");
+  return real_read(fd, data, size);
+}
+
+extern "C" ssize_t write(int fd, const void *data, size_t size) {
+  report("write()");
+  return raw_write(fd, data, size);
+}
+
+extern "C" int socket(int domain, int type, int protocol) {
+  REAL(socket);
+  report("socket()");
+  return real_socket(domain, type, protocol);
+}
+
+extern "C" int connect(int fd, const struct sockaddr *addr, socklen_t len) {
+  REAL(connect);
+  report("connect()");
+  return real_connect(fd, addr, len);
+}
+
+extern "C" ssize_t send(int fd, const void *data, size_t size, int flags) {
+  REAL(send);
+  report("send()");
+  return real_send(fd, data, size, flags);
+}
+
+extern "C" ssize_t recv(int fd, void *data, size_t size, int flags) {
+  REAL(recv);
+  report("recv()");
+  return real_recv(fd, data, size, flags);
+}
+
+extern "C" ssize_t sendto(int fd, const void *data, size_t size, int flags,
+                          const struct sockaddr *addr, socklen_t len) {
+  REAL(sendto);
+  report("sendto()");
+  return real_sendto(fd, data, size, flags, addr, len);
+}
+
+extern "C" ssize_t recvfrom(int fd, void *data, size_t size, int flags,
+                            struct sockaddr *addr, socklen_t *len) {
+  REAL(recvfrom);
+  report("recvfrom()");
+  return real_recvfrom(fd, data, size, flags, addr, len);
+}
+
+//==============================================================================
+static ssize_t raw_write(int fd, const void *data, size_t size) {
+  REAL(write);
+  return real_write(fd, data, size);
+}
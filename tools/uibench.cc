@@ -0,0 +1,726 @@
+#include "framework/nvgbackend.h"
+#include "framework/nvgfontatlas.h"
+#include "framework/fontatlas.h"
+#include "framework/telemetry.h"
+#include "framework/lv2all.h"
+#include "canvas.h"
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <nanovg.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdexcept>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <ctime>
+
+// Headless renderer which measures the cost of drawing NanoVG frames
+//
+// The GL context is created on an offscreen EGL surface, which works with a
+// software rasterizer such as Mesa llvmpipe on machines without a GPU.
+// The scene "ui" is the canvas of the project UI, fed with a synthetic stream
+// of telemetry events; the scene "panel" is a dense panel of widgets. The
+// scenes "text-atlas" and "text-nvg" draw the same static labels, with the
+// font atlas and with `nvgText`.
+// The last frame of each run can be saved, or compared with golden images.
+
+struct Options {
+  std::vector<std::string> backends {"gl2", "gl3"};
+  std::vector<std::string> scenes {"ui", "panel"};
+  unsigned frames = 300;
+  unsigned widgets = 256;
+  unsigned width = 800;
+  unsigned height = 600;
+  // ratio of device pixels to units, as the scale factor of a HiDPI display
+  float scale = 1;
+  std::string output_dir;
+  std::string golden_dir;
+  unsigned tolerance = 16;
+};
+
+struct Result {
+  std::string scene;
+  std::string backend;
+  unsigned nframes = 0;
+  unsigned nevents = 0;
+  double cpu_mean = 0;
+  double cpu_p50 = 0;
+  double cpu_p99 = 0;
+  double wall_mean = 0;
+  double wall_p99 = 0;
+  std::string golden;
+  unsigned long diff_pixels = 0;
+};
+
+// pixels of a frame, in RGB rows from the top
+struct Image {
+  unsigned width = 0;
+  unsigned height = 0;
+  std::vector<uint8_t> data;
+};
+
+//==============================================================================
+// GL context on an offscreen surface
+class OffscreenContext {
+ public:
+  OffscreenContext(unsigned width, unsigned height) {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+#if defined(EGL_PLATFORM_SURFACELESS_MESA)
+    if (get_platform_display)
+      display_ = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+#endif
+    if (display_ == EGL_NO_DISPLAY)
+      display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display_ == EGL_NO_DISPLAY || !eglInitialize(display_, nullptr, nullptr))
+      throw std::runtime_error("cannot initialize the EGL display");
+
+    const EGLint config_attribs[] = {
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+      EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+      EGL_STENCIL_SIZE, 8,
+      EGL_NONE,
+    };
+    EGLConfig config;
+    EGLint nconfigs = 0;
+    if (!eglChooseConfig(display_, config_attribs, &config, 1, &nconfigs) || nconfigs == 0)
+      throw std::runtime_error("cannot find an EGL configuration");
+
+    const EGLint surface_attribs[] = {
+      EGL_WIDTH, EGLint(width), EGL_HEIGHT, EGLint(height), EGL_NONE,
+    };
+    surface_ = eglCreatePbufferSurface(display_, config, surface_attribs);
+    if (surface_ == EGL_NO_SURFACE)
+      throw std::runtime_error("cannot create the EGL surface");
+
+    eglBindAPI(EGL_OPENGL_API);
+    context_ = eglCreateContext(display_, config, EGL_NO_CONTEXT, nullptr);
+    if (context_ == EGL_NO_CONTEXT)
+      throw std::runtime_error("cannot create the EGL context");
+    if (!eglMakeCurrent(display_, surface_, surface_, context_))
+      throw std::runtime_error("cannot make the EGL context current");
+  }
+
+  ~OffscreenContext() {
+    eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context_ != EGL_NO_CONTEXT)
+      eglDestroyContext(display_, context_);
+    if (surface_ != EGL_NO_SURFACE)
+      eglDestroySurface(display_, surface_);
+    eglTerminate(display_);
+  }
+
+ private:
+  EGLDisplay display_ = EGL_NO_DISPLAY;
+  EGLSurface surface_ = EGL_NO_SURFACE;
+  EGLContext context_ = EGL_NO_CONTEXT;
+};
+
+//==============================================================================
+class URIDMap {
+ public:
+  URIDMap() {
+    map_.handle = this;
+    map_.map = [](LV2_URID_Map_Handle h, const char *uri) -> LV2_URID {
+      return reinterpret_cast<URIDMap *>(h)->map(uri); };
+  }
+
+  LV2_URID map(const char *uri) {
+    auto it = ids_.find(uri);
+    if (it != ids_.end())
+      return it->second;
+    LV2_URID id = ids_.size() + 1;
+    ids_[uri] = id;
+    return id;
+  }
+
+  LV2_URID_Map *map_feature() { return &map_; }
+
+ private:
+  LV2_URID_Map map_;
+  std::unordered_map<std::string, LV2_URID> ids_;
+};
+
+//==============================================================================
+// content drawn by the benchmark, all the functions are called in the context
+class Scene {
+ public:
+  virtual ~Scene() {}
+  virtual unsigned width() const = 0;
+  virtual unsigned height() const = 0;
+  virtual void init(const NvgBackend &backend) = 0;
+  virtual void cleanup() = 0;
+  // produce the input of the frame, this is not measured
+  virtual void prepare(unsigned frame) {}
+  // process the input and draw the frame, return the count of events
+  virtual unsigned draw(unsigned frame) = 0;
+};
+
+// canvas of the UI, which receives the telemetry as port events
+class UIScene : public Scene {
+ public:
+  explicit UIScene(const Options &opt);
+  unsigned width() const override { return std::lround(Canvas::width * opt_.scale); }
+  unsigned height() const override { return std::lround(Canvas::height * opt_.scale); }
+  void init(const NvgBackend &backend) override;
+  void cleanup() override;
+  void prepare(unsigned frame) override;
+  unsigned draw(unsigned frame) override;
+
+ private:
+  static constexpr double rate = 48000;
+  static constexpr unsigned block_size = 800;
+  static constexpr unsigned sequence_size = 8192;
+  const Options &opt_;
+  URIDMap urid_;
+  LV2_URID event_transfer_ = 0;
+  LV2_URID atom_chunk_ = 0;
+  std::unique_ptr<TelemetryWriter> telemetry_;
+  std::unique_ptr<Canvas> canvas_;
+  std::vector<float> audio_[2];
+  std::unique_ptr<uint64_t[]> sequence_;
+};
+
+// dense panel of knobs with labels and readouts, animated over the frames
+class PanelScene : public Scene {
+ public:
+  explicit PanelScene(const Options &opt) : opt_(opt) {}
+  unsigned width() const override { return std::lround(opt_.width * opt_.scale); }
+  unsigned height() const override { return std::lround(opt_.height * opt_.scale); }
+  void init(const NvgBackend &backend) override;
+  void cleanup() override;
+  unsigned draw(unsigned frame) override;
+
+ private:
+  const Options &opt_;
+  const NvgBackend *backend_ = nullptr;
+  NVGcontext *vg_ = nullptr;
+};
+
+// grid of static labels, one per widget, drawn with the font atlas or with
+// `nvgText`, to compare the costs of both
+class TextScene : public Scene {
+ public:
+  TextScene(const Options &opt, bool atlas) : opt_(opt), atlas_(atlas) {}
+  unsigned width() const override { return std::lround(opt_.width * opt_.scale); }
+  unsigned height() const override { return std::lround(opt_.height * opt_.scale); }
+  void init(const NvgBackend &backend) override;
+  void cleanup() override;
+  unsigned draw(unsigned frame) override;
+
+ private:
+  const Options &opt_;
+  const bool atlas_;
+  const NvgBackend *backend_ = nullptr;
+  NVGcontext *vg_ = nullptr;
+  std::unique_ptr<NvgFontAtlas> fonts_;
+  std::vector<std::string> labels_;
+};
+
+//==============================================================================
+static int run_uibench(int argc, char *argv[]);
+static Result run_benchmark(const NvgBackend &backend, Scene &scene, const Options &opt, Image &image);
+static void read_image(Image &image, unsigned width, unsigned height);
+static bool save_image(const std::string &path, const Image &image);
+static bool load_image(const std::string &path, Image &image);
+static unsigned long compare_images(const Image &a, const Image &b, unsigned tolerance);
+static void print_result(std::ostream &os, const Result &r);
+
+#include "../resources/Roboto-Regular.ttf.c"
+
+int main(int argc, char *argv[]) {
+  // the failures of EGL, GLEW and NanoVG are exceptions, reported by the
+  // exit status
+  try {
+    return run_uibench(argc, argv);
+  }
+  catch (const std::exception &ex) {
+    std::cerr << "error: " << ex.what() << "\n";
+    return 1;
+  }
+}
+
+static int run_uibench(int argc, char *argv[]) {
+  Options opt;
+
+  auto parse_list = [](const char *arg, auto conv) {
+    std::vector<decltype(conv(std::string()))> list;
+    std::string str = arg;
+    for (size_t pos = 0, end; pos <= str.size(); pos = end + 1) {
+      end = std::min(str.find(',', pos), str.size());
+      list.push_back(conv(str.substr(pos, end - pos)));
+    }
+    return list;
+  };
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "-g" && has_value)
+      opt.backends = parse_list(argv[++i], [](const std::string &s) { return s; });
+    else if (arg == "-s" && has_value)
+      opt.scenes = parse_list(argv[++i], [](const std::string &s) { return s; });
+    else if (arg == "-n" && has_value)
+      opt.frames = std::stoul(argv[++i]);
+    else if (arg == "-w" && has_value)
+      opt.widgets = std::stoul(argv[++i]);
+    else if (arg == "-o" && has_value)
+      opt.output_dir = argv[++i];
+    else if (arg == "-c" && has_value)
+      opt.golden_dir = argv[++i];
+    else if (arg == "-t" && has_value)
+      opt.tolerance = std::stoul(argv[++i]);
+    else if (arg == "-x" && has_value)
+      opt.scale = std::stof(argv[++i]);
+    else {
+      opt.frames = 0;
+      break;
+    }
+  }
+
+  if (opt.frames == 0 || opt.backends.empty() || opt.scenes.empty() || !(opt.scale > 0)) {
+    std::cerr << "Usage: uibench [-g backends] [-s scenes] [-n frames] [-w widgets]"
+        " [-x scale] [-o output-dir] [-c golden-dir] [-t tolerance]\n";
+    return 1;
+  }
+
+  OffscreenContext context(
+      std::lround(std::max(opt.width, Canvas::width) * opt.scale),
+      std::lround(std::max(opt.height, Canvas::height) * opt.scale));
+
+  GLenum glew_status = glewInit();
+#if defined(GLEW_ERROR_NO_GLX_DISPLAY)
+  // the GL functions are loaded, only GLX is unavailable with EGL
+  if (glew_status == GLEW_ERROR_NO_GLX_DISPLAY)
+    glew_status = GLEW_OK;
+#endif
+  if (glew_status != GLEW_OK)
+    throw std::runtime_error("cannot initialize GLEW");
+
+  const char *renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+  const char *version = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+
+  std::cout << "{\n";
+  std::cout << "  \"renderer\": \"" << (renderer ? renderer : "") << "\",\n";
+  std::cout << "  \"version\": \"" << (version ? version : "") << "\",\n";
+  std::cout << "  \"selected_backend\": \"" << nvg_backend().name << "\",\n";
+  std::cout << "  \"widgets\": " << opt.widgets << ",\n";
+  std::cout << "  \"scale\": " << opt.scale << ",\n";
+  std::cout << "  \"results\": [";
+  bool first = true;
+  bool failed = false;
+  for (const std::string &scene_name : opt.scenes) {
+    std::unique_ptr<Scene> scene;
+    if (scene_name == "ui")
+      scene.reset(new UIScene(opt));
+    else if (scene_name == "panel")
+      scene.reset(new PanelScene(opt));
+    else if (scene_name == "text-atlas")
+      scene.reset(new TextScene(opt, true));
+    else if (scene_name == "text-nvg")
+      scene.reset(new TextScene(opt, false));
+    else {
+      std::cerr << "unknown scene: " << scene_name << "\n";
+      failed = true;
+      continue;
+    }
+    for (const std::string &name : opt.backends) {
+      const NvgBackend *backend = nullptr;
+      if (name == "gl2")
+        backend = &nvg_gl2_backend();
+      else if (name == "gl3" && GLEW_VERSION_3_2)
+        backend = &nvg_gl3_backend();
+      if (!backend) {
+        std::cerr << "backend not available: " << name << "\n";
+        continue;
+      }
+
+      Image image;
+      Result r = run_benchmark(*backend, *scene, opt, image);
+      r.scene = scene_name;
+
+      const std::string file_name = "/" + scene_name + "-" + name + ".ppm";
+      if (!opt.output_dir.empty() && !save_image(opt.output_dir + file_name, image)) {
+        std::cerr << "cannot write the image: " << opt.output_dir + file_name << "\n";
+        failed = true;
+      }
+      if (!opt.golden_dir.empty()) {
+        Image golden;
+        if (!load_image(opt.golden_dir + file_name, golden))
+          r.golden = "missing";
+        else {
+          r.diff_pixels = compare_images(image, golden, opt.tolerance);
+          // allow a few pixels of difference, for the variations of rasterizers
+          unsigned long max_diff_pixels = image.width * image.height / 1000;
+          r.golden = (r.diff_pixels <= max_diff_pixels) ? "match" : "mismatch";
+        }
+        failed = failed || r.golden != "match";
+      }
+
+      std::cout << (first ? "" : ",") << "\n    ";
+      print_result(std::cout, r);
+      first = false;
+    }
+  }
+  std::cout << "\n  ]\n}\n";
+
+  return failed ? 1 : 0;
+}
+
+//==============================================================================
+static double thread_cpu_time() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+static Result run_benchmark(const NvgBackend &backend, Scene &scene, const Options &opt, Image &image) {
+  scene.init(backend);
+
+  const unsigned warmup_frames = 16;
+  std::vector<double> cpu_times, wall_times;
+  cpu_times.reserve(opt.frames);
+  wall_times.reserve(opt.frames);
+  unsigned nevents = 0;
+
+  typedef std::chrono::steady_clock clock;
+  for (unsigned f = 0; f < warmup_frames + opt.frames; ++f) {
+    scene.prepare(f);
+
+    clock::time_point t1 = clock::now();
+    double c1 = thread_cpu_time();
+
+    unsigned n = scene.draw(f);
+
+    // the CPU cost of the UI thread, without waiting for the rasterizer
+    double c2 = thread_cpu_time();
+    glFinish();
+    clock::time_point t2 = clock::now();
+
+    if (f >= warmup_frames) {
+      cpu_times.push_back(c2 - c1);
+      wall_times.push_back(std::chrono::duration<double>(t2 - t1).count());
+      nevents += n;
+    }
+  }
+
+  read_image(image, scene.width(), scene.height());
+  scene.cleanup();
+
+  Result r;
+  r.backend = backend.name;
+  r.nframes = opt.frames;
+  r.nevents = nevents;
+
+  auto mean = [](const std::vector<double> &times) -> double {
+    double total = 0;
+    for (double t : times)
+      total += t;
+    return total / times.size();
+  };
+  auto percentile = [](std::vector<double> &times, double p) -> double {
+    std::sort(times.begin(), times.end());
+    size_t index = std::min(times.size() - 1, size_t(p * times.size()));
+    return times[index];
+  };
+  r.cpu_mean = mean(cpu_times);
+  r.cpu_p50 = percentile(cpu_times, 0.5);
+  r.cpu_p99 = percentile(cpu_times, 0.99);
+  r.wall_mean = mean(wall_times);
+  r.wall_p99 = percentile(wall_times, 0.99);
+
+  return r;
+}
+
+//==============================================================================
+UIScene::UIScene(const Options &opt)
+    : opt_(opt) {
+  event_transfer_ = urid_.map(LV2_ATOM__eventTransfer);
+  atom_chunk_ = urid_.map(LV2_ATOM__Chunk);
+  for (std::vector<float> &channel : audio_)
+    channel.resize(block_size);
+  sequence_.reset(new uint64_t[sequence_size / 8]());
+}
+
+void UIScene::init(const NvgBackend &backend) {
+  // start from the same state with every backend
+  LV2_URID_Map *map = urid_.map_feature();
+  telemetry_.reset(new TelemetryWriter(map, rate));
+  canvas_.reset(new Canvas(map, nullptr));
+  canvas_->set_pixel_ratio(opt_.scale);
+  if (!canvas_->init(backend))
+    throw std::runtime_error("cannot create the NanoVG context");
+}
+
+void UIScene::cleanup() {
+  canvas_->cleanup();
+}
+
+void UIScene::prepare(unsigned frame) {
+  // the output of a synth, whose level and pitch vary over the frames
+  const float pi = M_PI;
+  const unsigned note = 48 + frame % 24;
+  const float frequency = 440 * std::exp2((note - 69) / 12.0f);
+  const float level = 0.5f + 0.4f * std::sin(0.02f * frame);
+  for (unsigned i = 0; i < block_size; ++i) {
+    double t = (double(frame) * block_size + i) / rate;
+    float phase = float(std::fmod(frequency * t, 1.0));
+    audio_[0][i] = level * std::sin(2 * pi * phase);
+    audio_[1][i] = level * ((phase < 0.5f) ? 1.0f : -1.0f) * 0.5f;
+  }
+  const float *channels[2] = {audio_[0].data(), audio_[1].data()};
+  telemetry_->analyze(channels, 2, block_size);
+
+  uint64_t notes[2] = {};
+  notes[note / 64] |= uint64_t(1) << (note % 64);
+  telemetry_->set_voices(1 + frame % 8, notes);
+
+  LV2_Atom_Sequence *seq = reinterpret_cast<LV2_Atom_Sequence *>(sequence_.get());
+  seq->atom.type = atom_chunk_;
+  seq->atom.size = sequence_size - sizeof(LV2_Atom);
+  telemetry_->write(seq);
+}
+
+unsigned UIScene::draw(unsigned frame) {
+  // deliver the events as a host does, in the atom transfer format
+  unsigned nevents = 0;
+  const LV2_Atom_Sequence *seq = reinterpret_cast<const LV2_Atom_Sequence *>(sequence_.get());
+  LV2_ATOM_SEQUENCE_FOREACH(seq, ev) {
+    const LV2_Atom *atom = &ev->body;
+    // the canvas does not distinguish the ports
+    canvas_->port_event(0, lv2_atom_total_size(atom), event_transfer_, atom);
+    ++nevents;
+  }
+  canvas_->draw();
+  return nevents;
+}
+
+//==============================================================================
+void PanelScene::init(const NvgBackend &backend) {
+  NVGcontext *vg = backend.create(nvg_antialias|nvg_stencil_strokes);
+  if (!vg)
+    throw std::runtime_error("cannot create the NanoVG context");
+
+  nvgCreateFontMem(
+      vg, "sans",
+      const_cast<unsigned char *>(Roboto_Regular_ttf), sizeof(Roboto_Regular_ttf),
+      false);
+
+  backend_ = &backend;
+  vg_ = vg;
+}
+
+void PanelScene::cleanup() {
+  backend_->destroy(vg_);
+  vg_ = nullptr;
+}
+
+unsigned PanelScene::draw(unsigned frame) {
+  const Options &opt = opt_;
+  NVGcontext *vg = vg_;
+
+  glViewport(0, 0, width(), height());
+  glClearColor(0, 0, 0, 0);
+  glClear(GL_COLOR_BUFFER_BIT|GL_STENCIL_BUFFER_BIT);
+  nvgBeginFrame(vg, opt.width, opt.height, opt.scale);
+
+  const unsigned columns = 16;
+  const unsigned rows = (opt.widgets + columns - 1) / columns;
+  const float cw = float(opt.width) / columns;
+  const float ch = float(opt.height) / std::max(1u, rows);
+  const float pi = M_PI;
+
+  nvgFontFace(vg, "sans");
+  nvgFontSize(vg, std::min(12.0f, ch * 0.25f));
+  nvgTextAlign(vg, NVG_ALIGN_CENTER|NVG_ALIGN_TOP);
+
+  for (unsigned i = 0; i < opt.widgets; ++i) {
+    float x = (i % columns) * cw, y = (i / columns) * ch;
+    float cx = x + cw / 2, cy = y + ch * 0.4f;
+    float r = std::min(cw, ch) * 0.3f;
+    float value = 0.5f + 0.5f * std::sin(0.05f * frame + i);
+
+    nvgBeginPath(vg);
+    nvgRoundedRect(vg, x + 2, y + 2, cw - 4, ch - 4, 4);
+    nvgFillColor(vg, nvgRGB(40, 40, 40));
+    nvgFill(vg);
+
+    float a1 = 0.75f * pi, a2 = a1 + 1.5f * pi * value;
+    nvgBeginPath(vg);
+    nvgArc(vg, cx, cy, r, a1, 2.25f * pi, NVG_CW);
+    nvgStrokeColor(vg, nvgRGB(80, 80, 80));
+    nvgStrokeWidth(vg, 3);
+    nvgStroke(vg);
+    nvgBeginPath(vg);
+    nvgArc(vg, cx, cy, r, a1, a2, NVG_CW);
+    nvgStrokeColor(vg, nvgRGB(255, 200, 0));
+    nvgStroke(vg);
+
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.2f", value);
+    nvgFillColor(vg, nvgRGB(200, 200, 200));
+    nvgText(vg, cx, cy + r + 2, text, nullptr);
+  }
+
+  nvgEndFrame(vg);
+  return 0;
+}
+
+//==============================================================================
+void TextScene::init(const NvgBackend &backend) {
+  NVGcontext *vg = backend.create(nvg_antialias|nvg_stencil_strokes);
+  if (!vg)
+    throw std::runtime_error("cannot create the NanoVG context");
+
+  if (atlas_) {
+    // the text falls back to the same font, if the atlas misses a glyph
+    fonts_.reset(new NvgFontAtlas);
+    fonts_->add_fallback("sans", Roboto_Regular_ttf, sizeof(Roboto_Regular_ttf));
+    fonts_->set_pixel_ratio(opt_.scale);
+    if (!fonts_->init(vg, font_atlas_data()))
+      throw std::runtime_error("cannot create the image of the font atlas");
+  }
+  else {
+    nvgCreateFontMem(
+        vg, "sans",
+        const_cast<unsigned char *>(Roboto_Regular_ttf), sizeof(Roboto_Regular_ttf),
+        false);
+  }
+
+  static const char *const names[] = {
+    "Cutoff", "Resonance", "Attack", "Decay", "Sustain", "Release", "Detune", "Volume",
+  };
+  labels_.resize(opt_.widgets);
+  for (unsigned i = 0; i < opt_.widgets; ++i)
+    labels_[i] = std::string(names[i % 8]) + " " + std::to_string(i / 8 + 1);
+
+  backend_ = &backend;
+  vg_ = vg;
+}
+
+void TextScene::cleanup() {
+  fonts_.reset();
+  backend_->destroy(vg_);
+  vg_ = nullptr;
+}
+
+unsigned TextScene::draw(unsigned frame) {
+  const Options &opt = opt_;
+  NVGcontext *vg = vg_;
+
+  glViewport(0, 0, width(), height());
+  glClearColor(0, 0, 0, 0);
+  glClear(GL_COLOR_BUFFER_BIT|GL_STENCIL_BUFFER_BIT);
+  nvgBeginFrame(vg, opt.width, opt.height, opt.scale);
+
+  const unsigned columns = 8;
+  const unsigned rows = (opt.widgets + columns - 1) / columns;
+  const float cw = float(opt.width) / columns;
+  const float ch = float(opt.height) / std::max(1u, rows);
+  const NVGcolor color = nvgRGB(200, 200, 200);
+  const int align = NVG_ALIGN_LEFT|NVG_ALIGN_TOP;
+
+  if (!atlas_) {
+    nvgFontFace(vg, "sans");
+    nvgFontSize(vg, 12);
+    nvgTextAlign(vg, align);
+    nvgFillColor(vg, color);
+  }
+
+  for (unsigned i = 0; i < opt.widgets; ++i) {
+    float x = (i % columns) * cw + 4, y = (i / columns) * ch;
+    const char *label = labels_[i].c_str();
+    if (atlas_)
+      fonts_->text(vg, "sans", 12, align, color, x, y, label);
+    else
+      nvgText(vg, x, y, label, nullptr);
+  }
+
+  nvgEndFrame(vg);
+  return 0;
+}
+
+//==============================================================================
+static void read_image(Image &image, unsigned width, unsigned height) {
+  std::vector<uint8_t> pixels(4 * width * height);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+  // the rows of GL are from the bottom
+  image.width = width;
+  image.height = height;
+  image.data.resize(3 * width * height);
+  for (unsigned y = 0; y < height; ++y) {
+    const uint8_t *src = &pixels[4 * width * (height - 1 - y)];
+    uint8_t *dst = &image.data[3 * width * y];
+    for (unsigned x = 0; x < width; ++x) {
+      dst[3 * x] = src[4 * x];
+      dst[3 * x + 1] = src[4 * x + 1];
+      dst[3 * x + 2] = src[4 * x + 2];
+    }
+  }
+}
+
+static bool save_image(const std::string &path, const Image &image) {
+  FILE *fh = std::fopen(path.c_str(), "wb");
+  if (!fh)
+    return false;
+  std::fprintf(fh, "P6\n%u %u\n255\n", image.width, image.height);
+  bool success = std::fwrite(image.data.data(), 1, image.data.size(), fh) == image.data.size();
+  return std::fclose(fh) == 0 && success;
+}
+
+static bool load_image(const std::string &path, Image &image) {
+  FILE *fh = std::fopen(path.c_str(), "rb");
+  if (!fh)
+    return false;
+  unsigned width, height, maxval;
+  bool success = std::fscanf(fh, "P6 %u %u %u", &width, &height, &maxval) == 3 &&
+      maxval == 255 && std::fgetc(fh) != EOF;
+  if (success) {
+    image.width = width;
+    image.height = height;
+    image.data.resize(3 * width * height);
+    success = std::fread(image.data.data(), 1, image.data.size(), fh) == image.data.size();
+  }
+  std::fclose(fh);
+  return success;
+}
+
+// count the pixels which differ by more than the tolerance on any component
+static unsigned long compare_images(const Image &a, const Image &b, unsigned tolerance) {
+  if (a.width != b.width || a.height != b.height)
+    return (unsigned long)a.width * a.height;
+  unsigned long count = 0;
+  for (size_t i = 0, n = a.data.size(); i < n; i += 3) {
+    bool differs = false;
+    for (size_t j = i; j < i + 3; ++j)
+      differs = differs || unsigned(std::abs(int(a.data[j]) - int(b.data[j]))) > tolerance;
+    count += differs;
+  }
+  return count;
+}
+
+static void print_result(std::ostream &os, const Result &r) {
+  os << "{\"scene\": \"" << r.scene << "\""
+     << ", \"backend\": \"" << r.backend << "\""
+     << ", \"frames\": " << r.nframes
+     << ", \"events\": " << r.nevents
+     << ", \"cpu_ns_mean\": " << uint64_t(r.cpu_mean * 1e9)
+     << ", \"cpu_ns_p50\": " << uint64_t(r.cpu_p50 * 1e9)
+     << ", \"cpu_ns_p99\": " << uint64_t(r.cpu_p99 * 1e9)
+     << ", \"wall_ns_mean\": " << uint64_t(r.wall_mean * 1e9)
+     << ", \"wall_ns_p99\": " << uint64_t(r.wall_p99 * 1e9);
+  if (!r.golden.empty())
+    os << ", \"golden\": \"" << r.golden << "\""
+       << ", \"diff_pixels\": " << r.diff_pixels;
+  os << "}";
+}